@@ -15,6 +15,8 @@ public ConnectionAllocationStrategy(int startCount, int deltaCount, int maxCount
             _keepFree = keepFree;
         }
 
+        internal int MaxCount => _maxCount;
+
         public int CalculateNewConnectionCount(int currentCount, int connectedCount)
         {
             if (currentCount == 0) return _startCount;
@@ -1,26 +1,86 @@
+using System;
+using System.Threading;
+
 namespace Nowin
 {
     class ConnectionBlock
     {
+        readonly Server _server;
         readonly SaeaLayerCallback[] _connections;
+        internal readonly ListenerShard Shard;
+        internal readonly byte[] Buffer;
+        internal int ConnectedCount;
+        int _lastActivityTicks;
+        int _notReleasedCount;
+        volatile bool _retiring;
 
-        internal ConnectionBlock(Server server, ILayerFactory layerFactory, int connectionCount)
+        internal ConnectionBlock(Server server, ListenerShard shard, ILayerFactory layerFactory, ConnectionBufferPool bufferPool, int connectionCount)
         {
+            _server = server;
+            Shard = shard;
             _connections = new SaeaLayerCallback[connectionCount];
+            _notReleasedCount = connectionCount;
+            _lastActivityTicks = Environment.TickCount;
             var perConnectionBufferSize = layerFactory.PerConnectionBufferSize;
             var reserveAtEnd = layerFactory.CommonBufferSize;
             var constantsOffset = checked(connectionCount * perConnectionBufferSize);
-            var buffer = new byte[checked(constantsOffset + reserveAtEnd)];
-            layerFactory.InitCommonBuffer(buffer, constantsOffset);
+            Buffer = bufferPool.Rent(checked(constantsOffset + reserveAtEnd));
+            layerFactory.InitCommonBuffer(Buffer, constantsOffset);
             for (var i = 0; i < connectionCount; i++)
             {
-                var handler = (ITransportLayerHandler)layerFactory.Create(buffer, i * perConnectionBufferSize, constantsOffset, i);
-                var callback = new SaeaLayerCallback(handler, server.ListenSocket, server, i, server.ContextFlow);
+                var handler = (ITransportLayerHandler)layerFactory.Create(Buffer, i * perConnectionBufferSize, constantsOffset, i);
+                var callback = new SaeaLayerCallback(handler, this, server, i, server.ContextFlow);
                 _connections[i] = callback;
                 handler.PrepareAccept();
             }
         }
 
+        internal int ConnectionCount => _connections.Length;
+
+        internal bool IsRetiring => _retiring;
+
+        internal void ReportConnected()
+        {
+            Interlocked.Increment(ref ConnectedCount);
+            _lastActivityTicks = Environment.TickCount;
+        }
+
+        internal void ReportDisconnected()
+        {
+            Interlocked.Decrement(ref ConnectedCount);
+            _lastActivityTicks = Environment.TickCount;
+        }
+
+        internal bool IsIdleFor(TimeSpan window)
+        {
+            return ConnectedCount == 0 && unchecked(Environment.TickCount - _lastActivityTicks) >= window.TotalMilliseconds;
+        }
+
+        // Slots are released when they would start next accept, slots serving connection finish it first
+        internal void Retire()
+        {
+            _retiring = true;
+        }
+
+        // Where waiting accept cannot be cancelled, slot is released after it serves next connection it gets
+        internal void CancelWaitingAccepts()
+        {
+            foreach (var connection in _connections)
+            {
+                connection.CancelAccept();
+            }
+        }
+
+        internal void ReleaseConnection(SaeaLayerCallback connection)
+        {
+            connection.Dispose();
+            _server.ReportReleasedConnection(this);
+            if (Interlocked.Decrement(ref _notReleasedCount) == 0)
+            {
+                _server.ReportReleasedBlock(this);
+            }
+        }
+
         internal void Stop()
         {
             if (_connections == null) return;
@@ -30,4 +90,4 @@ internal void Stop()
             }
         }
     }
-}
\ No newline at end of file
+}
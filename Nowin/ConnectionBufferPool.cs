@@ -0,0 +1,54 @@
+using System.Collections.Generic;
+
+namespace Nowin
+{
+    // Keeps few buffers of released connection blocks so next growth does not need fresh allocation on Large Object Heap.
+    // It is not a slab cut into pieces: SAEA buffers and handler offsets of one block must point into one array,
+    // so each block rents whole array and any retained array big enough is reused for it.
+    class ConnectionBufferPool
+    {
+        readonly int _maxRetainedBuffers;
+        readonly List<byte[]> _buffers = new List<byte[]>();
+
+        internal ConnectionBufferPool(int maxRetainedBuffers)
+        {
+            _maxRetainedBuffers = maxRetainedBuffers;
+        }
+
+        internal byte[] Rent(int size)
+        {
+            lock (_buffers)
+            {
+                // Smallest big enough buffer, so bigger one stays for bigger block
+                var best = -1;
+                for (var i = 0; i < _buffers.Count; i++)
+                {
+                    var length = _buffers[i].Length;
+                    if (length < size) continue;
+                    if (best < 0 || length < _buffers[best].Length) best = i;
+                }
+                if (best >= 0)
+                {
+                    var buffer = _buffers[best];
+                    _buffers.RemoveAt(best);
+                    return buffer;
+                }
+            }
+            return new byte[size];
+        }
+
+        internal void Return(byte[] buffer)
+        {
+            lock (_buffers)
+            {
+                // Oldest buffer is dropped and left for GC, so memory is returned after spike
+                if (_buffers.Count >= _maxRetainedBuffers)
+                {
+                    if (_maxRetainedBuffers == 0) return;
+                    _buffers.RemoveAt(0);
+                }
+                _buffers.Add(buffer);
+            }
+        }
+    }
+}
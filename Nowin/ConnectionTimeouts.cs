@@ -0,0 +1,42 @@
+using System;
+
+namespace Nowin
+{
+    // Limits for how long connection slot could be held by client not sending data. Zero disables limit.
+    // Resolution is one second, values are rounded up.
+    public class ConnectionTimeouts
+    {
+        public ConnectionTimeouts(TimeSpan keepAlive, TimeSpan requestHead, int minRequestBodyDataRate, TimeSpan requestBodyGracePeriod)
+        {
+            if (minRequestBodyDataRate < 0) throw new ArgumentOutOfRangeException(nameof(minRequestBodyDataRate), minRequestBodyDataRate, "Must be non negative");
+            KeepAlive = keepAlive;
+            RequestHead = requestHead;
+            MinRequestBodyDataRate = minRequestBodyDataRate;
+            RequestBodyGracePeriod = requestBodyGracePeriod;
+            KeepAliveSeconds = ToSeconds(keepAlive);
+            RequestHeadSeconds = ToSeconds(requestHead);
+            RequestBodyGraceSeconds = Math.Max(1, ToSeconds(requestBodyGracePeriod));
+        }
+
+        static int ToSeconds(TimeSpan value)
+        {
+            if (value < TimeSpan.Zero) throw new ArgumentOutOfRangeException(nameof(value), value, "Must be non negative");
+            return (int)Math.Min(int.MaxValue / 2, Math.Ceiling(value.TotalSeconds));
+        }
+
+        // Waiting for next request on keep-alive connection
+        public TimeSpan KeepAlive { get; }
+
+        // From accepting connection or first byte of next request till whole request head is received
+        public TimeSpan RequestHead { get; }
+
+        // Bytes per second client must send when application reads request body, measured only while waiting for data
+        public int MinRequestBodyDataRate { get; }
+
+        public TimeSpan RequestBodyGracePeriod { get; }
+
+        internal readonly int KeepAliveSeconds;
+        internal readonly int RequestHeadSeconds;
+        internal readonly int RequestBodyGraceSeconds;
+    }
+}
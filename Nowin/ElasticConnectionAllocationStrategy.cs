@@ -0,0 +1,30 @@
+using System;
+
+namespace Nowin
+{
+    public class ElasticConnectionAllocationStrategy : ConnectionAllocationStrategy, IElasticConnectionAllocationStrategy
+    {
+        readonly int _startCount;
+        readonly int _deltaCount;
+        readonly int _keepFree;
+
+        public ElasticConnectionAllocationStrategy(int startCount, int deltaCount, int maxCount, int keepFree, TimeSpan idleWindow)
+            : base(startCount, deltaCount, maxCount, keepFree)
+        {
+            if (idleWindow <= TimeSpan.Zero) throw new ArgumentOutOfRangeException(nameof(idleWindow), idleWindow, "Must be positive");
+            _startCount = startCount;
+            _deltaCount = deltaCount;
+            _keepFree = keepFree;
+            IdleWindow = idleWindow;
+        }
+
+        public TimeSpan IdleWindow { get; }
+
+        public int CalculateReleasableConnectionCount(int currentCount, int connectedCount)
+        {
+            // Hysteresis: after release there must stay at least one growth step above keepFree, so it does not grow again immediately
+            var overProvisioned = currentCount - connectedCount - _keepFree - _deltaCount;
+            return Math.Min(overProvisioned, currentCount - _startCount);
+        }
+    }
+}
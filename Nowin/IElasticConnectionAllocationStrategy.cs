@@ -0,0 +1,13 @@
+using System;
+
+namespace Nowin
+{
+    public interface IElasticConnectionAllocationStrategy : IConnectionAllocationStrategy
+    {
+        // How long all connections of block have to be idle before block could be released
+        TimeSpan IdleWindow { get; }
+
+        // Upper bound of connections which could be released now, zero or negative means none
+        int CalculateReleasableConnectionCount(int currentCount, int connectedCount);
+    }
+}
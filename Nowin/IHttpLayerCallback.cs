@@ -47,5 +47,10 @@ public interface IHttpLayerCallback : ILayerCallback
         int SendDataLength { get; }
 
         Task SendData(byte[] buffer, int offset, int length);
+        Task SendFileAsync(string fileName, long offset, long? count, CancellationToken cancel);
+
+        // Sends whole response prepared by cache layer instead of calling ResponseFinished. Head contains status line
+        // and headers without Date and final CRLF. Returns false when it cannot be used for this request.
+        bool TrySendCachedResponse(byte[] head, int age, byte[] body);
     }
 }
\ No newline at end of file
@@ -8,4 +8,4 @@ public interface INowinServer : IDisposable
         int ConnectionCount { get; }
         int CurrentMaxConnectionCount { get; }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,11 @@
+namespace Nowin
+{
+    // Implemented by servers from ServerBuilder next to INowinServer, kept separate so INowinServer implementations outside Nowin don't break
+    public interface INowinServerMetrics
+    {
+        // Connections of released blocks which still wait for their last accept
+        int RetiredConnectionCount { get; }
+        // null when metrics are not enabled in ServerBuilder
+        ServerMetrics Metrics { get; }
+    }
+}
@@ -20,5 +20,14 @@ interface IServerParameters
         TimeSpan RetrySocketBindingTime { get; }
         SslProtocols Protocols { get; }
         bool ClientCertificateRequired { get; }
+        int ListenBacklog { get; }
+        int ListenerShards { get; }
+        bool MetricsEnabled { get; }
+        string MetricsEndpointPath { get; }
+        int MetricsLatencySampleInterval { get; }
+        ConnectionTimeouts ConnectionTimeouts { get; }
+        long ResponseCacheSize { get; }
+        int ResponseCacheMaxEntrySize { get; }
+        bool ResponseCacheRequestsWithCookies { get; }
     }
 }
\ No newline at end of file
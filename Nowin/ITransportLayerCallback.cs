@@ -1,3 +1,6 @@
+using System;
+using System.Collections.Generic;
+
 namespace Nowin
 {
     public interface ITransportLayerCallback : ILayerCallback
@@ -5,6 +8,8 @@ public interface ITransportLayerCallback : ILayerCallback
         void StartAccept(byte[] buffer, int offset, int length);
         void StartReceive(byte[] buffer, int offset, int length);
         void StartSend(byte[] buffer, int offset, int length);
+        void StartSend(IList<ArraySegment<byte>> buffers);
+        void StartSendFile(IList<ArraySegment<byte>> head, string fileName, long offset, long count, ArraySegment<byte> tail);
         void StartDisconnect();
     }
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+using System.Collections.Generic;
+using System.Linq;
+
+namespace Nowin
+{
+    // Interned strings for well known request header names and common values, so parsing of typical request head does not allocate them again and again.
+    static class KnownHeaders
+    {
+        static readonly string[] Names =
+        {
+            "Host",
+            "Connection",
+            "Accept",
+            "Accept-Charset",
+            "Accept-Encoding",
+            "Accept-Language",
+            "Authorization",
+            "Cache-Control",
+            "Content-Length",
+            "Content-Type",
+            "Cookie",
+            "DNT",
+            "Expect",
+            "If-Match",
+            "If-Modified-Since",
+            "If-None-Match",
+            "Origin",
+            "Pragma",
+            "Range",
+            "Referer",
+            "Sec-Fetch-Dest",
+            "Sec-Fetch-Mode",
+            "Sec-Fetch-Site",
+            "Sec-Fetch-User",
+            "Sec-WebSocket-Extensions",
+            "Sec-WebSocket-Key",
+            "Sec-WebSocket-Protocol",
+            "Sec-WebSocket-Version",
+            "TE",
+            "Transfer-Encoding",
+            "Upgrade",
+            "Upgrade-Insecure-Requests",
+            "User-Agent",
+            "X-Forwarded-For",
+            "X-Forwarded-Proto",
+            "X-Requested-With"
+        };
+
+        static readonly string[] Values =
+        {
+            "keep-alive",
+            "Keep-Alive",
+            "close",
+            "Close",
+            "Upgrade",
+            "keep-alive, Upgrade",
+            "websocket",
+            "13",
+            "100-continue",
+            "chunked",
+            "trailers",
+            "0",
+            "1",
+            "?1",
+            "*/*",
+            "application/json",
+            "application/json, text/plain, */*",
+            "application/x-www-form-urlencoded",
+            "text/plain",
+            "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8",
+            "text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,*/*;q=0.8",
+            "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8",
+            "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8,application/signed-exchange;v=b3;q=0.7",
+            "gzip",
+            "gzip, deflate",
+            "gzip, deflate, br",
+            "gzip, deflate, br, zstd",
+            "en-US,en;q=0.9",
+            "en-US,en;q=0.5",
+            "en-US",
+            "no-cache",
+            "max-age=0",
+            "document",
+            "empty",
+            "image",
+            "script",
+            "style",
+            "navigate",
+            "no-cors",
+            "cors",
+            "same-origin",
+            "same-site",
+            "cross-site",
+            "none",
+            "XMLHttpRequest",
+            "http",
+            "https"
+        };
+
+        // Index is string length, entries contain canonical and lower case spelling of names
+        static readonly string[][] NamesByLength;
+        static readonly int[][] SlotsByLength;
+        static readonly string[][] ValuesByLength;
+
+        internal static int SlotCount => Names.Length;
+
+        static KnownHeaders()
+        {
+            var names = new List<KeyValuePair<string, int>>();
+            for (var i = 0; i < Names.Length; i++)
+            {
+                names.Add(new KeyValuePair<string, int>(Names[i], i));
+                var lower = Names[i].ToLowerInvariant();
+                if (lower != Names[i]) names.Add(new KeyValuePair<string, int>(lower, i));
+            }
+            var maxNameLength = Names.Max(n => n.Length);
+            NamesByLength = new string[maxNameLength + 1][];
+            SlotsByLength = new int[maxNameLength + 1][];
+            for (var len = 0; len <= maxNameLength; len++)
+            {
+                var l = len;
+                NamesByLength[len] = names.Where(p => p.Key.Length == l).Select(p => p.Key).ToArray();
+                SlotsByLength[len] = names.Where(p => p.Key.Length == l).Select(p => p.Value).ToArray();
+            }
+            var maxValueLength = Values.Max(n => n.Length);
+            ValuesByLength = new string[maxValueLength + 1][];
+            for (var len = 0; len <= maxValueLength; len++)
+            {
+                var l = len;
+                ValuesByLength[len] = Values.Where(v => v.Length == l).ToArray();
+            }
+        }
+
+        /// <returns>interned name or null if unknown, slot is index usable for per connection caching of values</returns>
+        internal static string TryGetName(byte[] buffer, int start, int end, out int slot)
+        {
+            var len = end - start;
+            if (len < NamesByLength.Length)
+            {
+                var candidates = NamesByLength[len];
+                for (var i = 0; i < candidates.Length; i++)
+                {
+                    var candidate = candidates[i];
+                    if (candidate[0] == buffer[start] && RequestHeadScanner.EqualsLatin1(candidate, buffer, start))
+                    {
+                        slot = SlotsByLength[len][i];
+                        return candidate;
+                    }
+                }
+            }
+            slot = -1;
+            return null;
+        }
+
+        /// <returns>interned value or null if it is not common</returns>
+        internal static string TryGetValue(byte[] buffer, int start, int end)
+        {
+            var len = end - start;
+            if (len >= ValuesByLength.Length) return null;
+            if (len == 0) return "";
+            var candidates = ValuesByLength[len];
+            for (var i = 0; i < candidates.Length; i++)
+            {
+                var candidate = candidates[i];
+                if (candidate[0] == buffer[start] && RequestHeadScanner.EqualsLatin1(candidate, buffer, start))
+                {
+                    return candidate;
+                }
+            }
+            return null;
+        }
+    }
+}
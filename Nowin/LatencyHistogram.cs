@@ -0,0 +1,81 @@
+using System.Threading;
+
+namespace Nowin
+{
+    // Log-linear (HDR style) histogram of microseconds. Every power of two range is split into 8 buckets so relative error is below 12.5%.
+    // Each stripe has its own buckets so threads running on different cores mostly don't touch same cache lines.
+    // Stripe is 2kb, so all stages of all stripes stay in cache of busy server.
+    sealed class LatencyHistogram
+    {
+        const int SubBucketBits = 3;
+        const int SubBucketCount = 1 << SubBucketBits;
+        // Values over 2^32 microseconds (71 minutes) are counted in last bucket
+        const int MaxShift = 32 - SubBucketBits;
+        internal const int BucketCount = (MaxShift + 2) * SubBucketCount;
+        // Sum is stored after buckets, rest of cache line is padding
+        const int SumIndex = BucketCount;
+        const int StripeLength = BucketCount + 8;
+
+        readonly long[][] _stripes;
+
+        internal LatencyHistogram(int stripeCount)
+        {
+            _stripes = new long[stripeCount][];
+            for (var i = 0; i < stripeCount; i++)
+            {
+                _stripes[i] = new long[StripeLength];
+            }
+        }
+
+        internal void Record(int stripe, long microseconds)
+        {
+            if (microseconds < 0) microseconds = 0;
+            var buckets = _stripes[stripe];
+            Interlocked.Increment(ref buckets[BucketIndex(microseconds)]);
+            Interlocked.Add(ref buckets[SumIndex], microseconds);
+        }
+
+        internal LatencySnapshot Snapshot()
+        {
+            var counts = new long[BucketCount];
+            long sum = 0;
+            foreach (var stripe in _stripes)
+            {
+                for (var i = 0; i < BucketCount; i++)
+                {
+                    counts[i] += Volatile.Read(ref stripe[i]);
+                }
+                sum += Volatile.Read(ref stripe[SumIndex]);
+            }
+            return new LatencySnapshot(counts, sum);
+        }
+
+        internal static int BucketIndex(long value)
+        {
+            if (value < 2 * SubBucketCount) return (int)value;
+            var shift = HighestBit(value) - SubBucketBits;
+            if (shift > MaxShift) return BucketCount - 1;
+            return (shift + 1) * SubBucketCount + (int)((value >> shift) & (SubBucketCount - 1));
+        }
+
+        // Highest value which falls into same bucket
+        internal static long BucketHighestValue(int index)
+        {
+            if (index < 2 * SubBucketCount) return index;
+            var shift = index / SubBucketCount - 1;
+            return ((long)(SubBucketCount + index % SubBucketCount) << shift) + (1L << shift) - 1;
+        }
+
+        static int HighestBit(long value)
+        {
+            var result = 0;
+            if (value >= 1L << 32) { value >>= 32; result += 32; }
+            if (value >= 1L << 16) { value >>= 16; result += 16; }
+            if (value >= 1L << 8) { value >>= 8; result += 8; }
+            if (value >= 1L << 4) { value >>= 4; result += 4; }
+            if (value >= 1L << 2) { value >>= 2; result += 2; }
+            if (value >= 1L << 1) result += 1;
+            return result;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+using System;
+
+namespace Nowin
+{
+    // Point in time copy of one latency histogram, percentiles are reported as upper bound of bucket
+    public class LatencySnapshot
+    {
+        readonly long[] _counts;
+        readonly long _sumMicroseconds;
+
+        internal LatencySnapshot(long[] counts, long sumMicroseconds)
+        {
+            _counts = counts;
+            _sumMicroseconds = sumMicroseconds;
+            foreach (var count in counts)
+            {
+                Count += count;
+            }
+        }
+
+        public long Count { get; }
+
+        public TimeSpan Sum => FromMicroseconds(_sumMicroseconds);
+
+        public TimeSpan Mean => Count == 0 ? TimeSpan.Zero : FromMicroseconds(_sumMicroseconds / Count);
+
+        public TimeSpan Max
+        {
+            get
+            {
+                for (var i = _counts.Length - 1; i >= 0; i--)
+                {
+                    if (_counts[i] != 0) return FromMicroseconds(LatencyHistogram.BucketHighestValue(i));
+                }
+                return TimeSpan.Zero;
+            }
+        }
+
+        // percentile in range 0 to 100
+        public TimeSpan GetPercentile(double percentile)
+        {
+            if (percentile < 0 || percentile > 100) throw new ArgumentOutOfRangeException(nameof(percentile), percentile, "Must be in range <0,100>");
+            if (Count == 0) return TimeSpan.Zero;
+            var target = Math.Max(1, (long)Math.Ceiling(Count * percentile / 100));
+            long seen = 0;
+            for (var i = 0; i < _counts.Length; i++)
+            {
+                seen += _counts[i];
+                if (seen >= target) return FromMicroseconds(LatencyHistogram.BucketHighestValue(i));
+            }
+            return Max;
+        }
+
+        static TimeSpan FromMicroseconds(long microseconds)
+        {
+            return TimeSpan.FromTicks(microseconds * (TimeSpan.TicksPerMillisecond / 1000));
+        }
+    }
+}
@@ -0,0 +1,119 @@
+using System;
+using System.Collections.Generic;
+using System.Net.Sockets;
+using System.Runtime.InteropServices;
+
+namespace Nowin
+{
+    // One of listen sockets bound to same endpoint with SO_REUSEPORT, kernel then spreads incoming connections between them
+    class ListenerShard
+    {
+        internal readonly Socket Socket;
+        internal readonly int Index;
+        internal int AllocatedConnections;
+        internal int ConnectedCount;
+
+        internal ListenerShard(Socket socket, int index)
+        {
+            Socket = socket;
+            Index = index;
+        }
+
+        internal int FreeConnections => AllocatedConnections - ConnectedCount;
+
+        // Decided once by enabling option on throwaway socket, so unknown OS or old kernel means single listen socket
+        internal static bool IsReusePortSupported => ReusePortSupported.Value;
+
+        static readonly Lazy<bool> ReusePortSupported = new Lazy<bool>(ProbeReusePort);
+
+        static bool ProbeReusePort()
+        {
+            var platform = Environment.OSVersion.Platform;
+            if (platform != PlatformID.Unix && platform != PlatformID.MacOSX) return false;
+            if (ReusePortOption() == null) return false;
+            using (var socket = new Socket(AddressFamily.InterNetworkV6, SocketType.Stream, ProtocolType.Tcp))
+            {
+                try
+                {
+                    EnableReusePort(socket);
+                    return true;
+                }
+                catch (SocketException ex)
+                {
+                    TraceSources.Core.TraceWarning("SO_REUSEPORT could not be enabled: {0}", ex.Message);
+                    return false;
+                }
+            }
+        }
+
+        internal static Socket CreateSocket(bool reusePort)
+        {
+            var socket = new Socket(AddressFamily.InterNetworkV6, SocketType.Stream, ProtocolType.Tcp);
+            try
+            {
+                socket.SetSocketOption(SocketOptionLevel.IPv6, SocketOptionName.IPv6Only, false);
+                if (reusePort) EnableReusePort(socket);
+            }
+            catch
+            {
+                socket.Dispose();
+                throw;
+            }
+            return socket;
+        }
+
+        static void EnableReusePort(Socket socket)
+        {
+            var value = 1;
+            var option = ReusePortOption().Value;
+            if (setsockopt(socket.Handle, option.Key, option.Value, ref value, sizeof(int)) != 0)
+                throw new SocketException(Marshal.GetLastWin32Error());
+        }
+
+        // SOL_SOCKET level and SO_REUSEPORT name differ between kernels, null for kernel without known values
+        static KeyValuePair<int, int>? ReusePortOption()
+        {
+            switch (OperatingSystemName())
+            {
+                case "Linux":
+                    return new KeyValuePair<int, int>(1, 15);
+                case "Darwin":
+                case "FreeBSD":
+                case "NetBSD":
+                case "OpenBSD":
+                    return new KeyValuePair<int, int>(0xffff, 0x200);
+                default:
+                    return null;
+            }
+        }
+
+        static string OperatingSystemName()
+        {
+            // struct utsname starts with sysname on all Unixes, buffer is bigger than any of its layouts
+            var buffer = Marshal.AllocHGlobal(8192);
+            try
+            {
+                if (uname(buffer) != 0) return null;
+                return Marshal.PtrToStringAnsi(buffer);
+            }
+            catch (DllNotFoundException)
+            {
+                return null;
+            }
+            catch (EntryPointNotFoundException)
+            {
+                return null;
+            }
+            finally
+            {
+                Marshal.FreeHGlobal(buffer);
+            }
+        }
+
+        [DllImport("libc", SetLastError = true)]
+        static extern int setsockopt(IntPtr socket, int level, int optionName, ref int optionValue, uint optionLength);
+
+        [DllImport("libc", SetLastError = true)]
+        static extern int uname(IntPtr buffer);
+    }
+}
@@ -0,0 +1,23 @@
+namespace Nowin
+{
+    public enum MetricsCounter
+    {
+        ConnectionsAccepted,
+        Requests,
+        BytesReceived,
+        BytesSent,
+        Status1xx,
+        Status2xx,
+        Status3xx,
+        Status4xx,
+        Status5xx,
+        // Connections closed in middle of request or response
+        ConnectionAborts,
+        TlsHandshakeFailures,
+        // Connections closed because of keep-alive, request head or request body rate timeout
+        ConnectionTimeouts,
+        // Only requests which could be served from response cache are counted
+        ResponseCacheHits,
+        ResponseCacheMisses
+    }
+}
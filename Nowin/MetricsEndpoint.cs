@@ -0,0 +1,43 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace Nowin
+{
+    // Serves ServerMetrics in Prometheus text format on one path, all other requests are passed to application
+    class MetricsEndpoint
+    {
+        readonly Func<IDictionary<string, object>, Task> _next;
+        readonly ServerMetrics _metrics;
+        readonly string _path;
+
+        internal MetricsEndpoint(Func<IDictionary<string, object>, Task> next, ServerMetrics metrics, string path)
+        {
+            _next = next;
+            _metrics = metrics;
+            _path = path;
+        }
+
+        internal Task Invoke(IDictionary<string, object> env)
+        {
+            if (!string.Equals((string)env[OwinKeys.RequestPath], _path, StringComparison.Ordinal))
+                return _next(env);
+            var method = (string)env[OwinKeys.RequestMethod];
+            if (method != "GET" && method != "HEAD")
+            {
+                env[OwinKeys.ResponseStatusCode] = 405;
+                return Task.Delay(0);
+            }
+            var writer = new StringWriter();
+            _metrics.WriteText(writer);
+            var body = Encoding.UTF8.GetBytes(writer.ToString());
+            var headers = (IDictionary<string, string[]>)env[OwinKeys.ResponseHeaders];
+            headers["Content-Type"] = new[] { "text/plain; version=0.0.4" };
+            headers["Cache-Control"] = new[] { "no-cache" };
+            headers["Content-Length"] = new[] { body.Length.ToString() };
+            return ((Stream)env[OwinKeys.ResponseBody]).WriteAsync(body, 0, body.Length);
+        }
+    }
+}
@@ -0,0 +1,19 @@
+namespace Nowin
+{
+    public enum MetricsStage
+    {
+        // Handing accepted socket over to connection handler
+        Accept,
+        // From accept to first received byte of first request
+        RequestHead,
+        // Parsing of request line and headers
+        Parse,
+        // From calling OWIN app till response is finished
+        App,
+        // Sending rest of response after app finished
+        Send,
+        // From end of previous response to first byte of next request on keep-alive connection
+        KeepAliveIdle,
+        TlsHandshake
+    }
+}
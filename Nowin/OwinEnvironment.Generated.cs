@@ -12,11 +12,14 @@
 namespace Nowin
 {
     using WebSocketAccept = Action<IDictionary<string, object>, Func<IDictionary<string, object>, Task>>;
+    using SendFileFunc = Func<string /* filePath */, long /* offset */, long? /* byteCount */, CancellationToken /* cancel */, Task>;
 
     internal partial class OwinEnvironment
     {
         UInt32 _flag0;
         UInt32 _initFlag0;
+        UInt32 _flag1;
+        UInt32 _initFlag1;
 
         object _OwinVersion;
         object _CallCancelled;
@@ -42,11 +45,22 @@ internal partial class OwinEnvironment
         object _ServerLocalPort;
         object _ServerIsLocal;
         object _WebSocketAcceptFunc;
+        object _SendFileAsync;
+        object _ResponseProtocol;
+        object _RequestId;
+        object _RequestUser;
+        object _ServerUser;
+        object _HostTraceOutput;
+        object _HostAppName;
+        object _HostAppMode;
+        object _HostOnAppDisposing;
 
         void PropertiesReset()
         {
-            _flag0 = 0xffffffu;
-            _initFlag0 = 0xffffffu;
+            _flag0 = 0x1ffffffu;
+            _initFlag0 = 0x1ffffffu;
+            _flag1 = 0x0u;
+            _initFlag1 = 0x0u;
              _OwinVersion = null;
              _CallCancelled = null;
              _RequestProtocol = null;
@@ -71,6 +85,15 @@ void PropertiesReset()
              _ServerLocalPort = null;
              _ServerIsLocal = null;
              _WebSocketAcceptFunc = null;
+             _SendFileAsync = null;
+             _ResponseProtocol = null;
+             _RequestId = null;
+             _RequestUser = null;
+             _ServerUser = null;
+             _HostTraceOutput = null;
+             _HostAppName = null;
+             _HostAppMode = null;
+             _HostOnAppDisposing = null;
         }
 
         internal object OwinVersion
@@ -652,6 +675,182 @@ internal void RemoveWebSocketAcceptFunc()
             _flag0 &= ~0x800000u;
         }
 
+        internal object SendFileAsync
+        {
+            get
+            {
+                if (((_initFlag0 & 0x1000000u) != 0))
+                {
+                    _SendFileAsync = _handler.SendFileAsyncFunc;
+                    _initFlag0 &= ~0x1000000u;
+                }
+                return _SendFileAsync;
+            }
+            set
+            {
+                _initFlag0 &= ~0x1000000u;
+                _flag0 |= 0x1000000u;
+                _SendFileAsync = value;
+            }
+        }
+
+        internal void RemoveSendFileAsync()
+        {
+            _flag0 &= ~0x1000000u;
+        }
+
+        internal object ResponseProtocol
+        {
+            get
+            {
+                return _ResponseProtocol;
+            }
+            set
+            {
+                _initFlag0 &= ~0x2000000u;
+                _flag0 |= 0x2000000u;
+                _ResponseProtocol = value;
+            }
+        }
+
+        internal void RemoveResponseProtocol()
+        {
+            _flag0 &= ~0x2000000u;
+        }
+
+        internal object RequestId
+        {
+            get
+            {
+                return _RequestId;
+            }
+            set
+            {
+                _initFlag0 &= ~0x4000000u;
+                _flag0 |= 0x4000000u;
+                _RequestId = value;
+            }
+        }
+
+        internal void RemoveRequestId()
+        {
+            _flag0 &= ~0x4000000u;
+        }
+
+        internal object RequestUser
+        {
+            get
+            {
+                return _RequestUser;
+            }
+            set
+            {
+                _initFlag0 &= ~0x8000000u;
+                _flag0 |= 0x8000000u;
+                _RequestUser = value;
+            }
+        }
+
+        internal void RemoveRequestUser()
+        {
+            _flag0 &= ~0x8000000u;
+        }
+
+        internal object ServerUser
+        {
+            get
+            {
+                return _ServerUser;
+            }
+            set
+            {
+                _initFlag0 &= ~0x10000000u;
+                _flag0 |= 0x10000000u;
+                _ServerUser = value;
+            }
+        }
+
+        internal void RemoveServerUser()
+        {
+            _flag0 &= ~0x10000000u;
+        }
+
+        internal object HostTraceOutput
+        {
+            get
+            {
+                return _HostTraceOutput;
+            }
+            set
+            {
+                _initFlag0 &= ~0x20000000u;
+                _flag0 |= 0x20000000u;
+                _HostTraceOutput = value;
+            }
+        }
+
+        internal void RemoveHostTraceOutput()
+        {
+            _flag0 &= ~0x20000000u;
+        }
+
+        internal object HostAppName
+        {
+            get
+            {
+                return _HostAppName;
+            }
+            set
+            {
+                _initFlag0 &= ~0x40000000u;
+                _flag0 |= 0x40000000u;
+                _HostAppName = value;
+            }
+        }
+
+        internal void RemoveHostAppName()
+        {
+            _flag0 &= ~0x40000000u;
+        }
+
+        internal object HostAppMode
+        {
+            get
+            {
+                return _HostAppMode;
+            }
+            set
+            {
+                _initFlag0 &= ~0x80000000u;
+                _flag0 |= 0x80000000u;
+                _HostAppMode = value;
+            }
+        }
+
+        internal void RemoveHostAppMode()
+        {
+            _flag0 &= ~0x80000000u;
+        }
+
+        internal object HostOnAppDisposing
+        {
+            get
+            {
+                return _HostOnAppDisposing;
+            }
+            set
+            {
+                _initFlag1 &= ~0x1u;
+                _flag1 |= 0x1u;
+                _HostOnAppDisposing = value;
+            }
+        }
+
+        internal void RemoveHostOnAppDisposing()
+        {
+            _flag1 &= ~0x1u;
+        }
+
         private bool PropertiesContainsKey(string key)
         {
             switch (key.Length)
@@ -661,6 +860,14 @@ private bool PropertiesContainsKey(string key)
                     {
                         return true;
                     }
+                    if (((_flag0 & 0x40000000u) != 0) && key=="host.AppName")
+                    {
+                        return true;
+                    }
+                    if (((_flag0 & 0x80000000u) != 0) && key=="host.AppMode")
+                    {
+                        return true;
+                    }
                    break;
                 case 18:
                     if (((_flag0 & 0x2u) != 0) && key=="owin.CallCancelled")
@@ -675,6 +882,10 @@ private bool PropertiesContainsKey(string key)
                     {
                         return true;
                     }
+                    if (((_flag0 & 0x1000000u) != 0) && key=="sendfile.SendAsync")
+                    {
+                        return true;
+                    }
                    break;
                 case 20:
                     if (((_flag0 & 0x4u) != 0) && key=="owin.RequestProtocol")
@@ -707,6 +918,14 @@ private bool PropertiesContainsKey(string key)
                     {
                         return true;
                     }
+                    if (((_flag0 & 0x8000000u) != 0) && key=="owin.RequestUser")
+                    {
+                        return true;
+                    }
+                    if (((_flag0 & 0x20000000u) != 0) && key=="host.TraceOutput")
+                    {
+                        return true;
+                    }
                    break;
                 case 23:
                     if (((_flag0 & 0x80u) != 0) && key=="owin.RequestQueryString")
@@ -731,6 +950,10 @@ private bool PropertiesContainsKey(string key)
                     {
                         return true;
                     }
+                    if (((_flag1 & 0x1u) != 0) && key=="host.OnAppDisposing")
+                    {
+                        return true;
+                    }
                    break;
                 case 25:
                     if (((_flag0 & 0x800u) != 0) && key=="owin.ResponseReasonPhrase")
@@ -761,6 +984,10 @@ private bool PropertiesContainsKey(string key)
                     {
                         return true;
                     }
+                    if (((_flag0 & 0x2000000u) != 0) && key=="owin.ResponseProtocol")
+                    {
+                        return true;
+                    }
                    break;
                 case 22:
                     if (((_flag0 & 0x40000u) != 0) && key=="server.RemoteIpAddress")
@@ -773,6 +1000,16 @@ private bool PropertiesContainsKey(string key)
                     {
                         return true;
                     }
+                    if (((_flag0 & 0x4000000u) != 0) && key=="owin.RequestId")
+                    {
+                        return true;
+                    }
+                   break;
+                case 11:
+                    if (((_flag0 & 0x10000000u) != 0) && key=="server.User")
+                    {
+                        return true;
+                    }
                    break;
             }
             return false;
@@ -788,6 +1025,16 @@ private bool PropertiesTryGetValue(string key, out object value)
                         value = OwinVersion;
                         return true;
                     }
+                    if (((_flag0 & 0x40000000u) != 0) && key=="host.AppName")
+                    {
+                        value = HostAppName;
+                        return true;
+                    }
+                    if (((_flag0 & 0x80000000u) != 0) && key=="host.AppMode")
+                    {
+                        value = HostAppMode;
+                        return true;
+                    }
                    break;
                 case 18:
                     if (((_flag0 & 0x2u) != 0) && key=="owin.CallCancelled")
@@ -805,6 +1052,11 @@ private bool PropertiesTryGetValue(string key, out object value)
                         value = RequestScheme;
                         return true;
                     }
+                    if (((_flag0 & 0x1000000u) != 0) && key=="sendfile.SendAsync")
+                    {
+                        value = SendFileAsync;
+                        return true;
+                    }
                    break;
                 case 20:
                     if (((_flag0 & 0x4u) != 0) && key=="owin.RequestProtocol")
@@ -844,6 +1096,16 @@ private bool PropertiesTryGetValue(string key, out object value)
                         value = WebSocketAcceptFunc;
                         return true;
                     }
+                    if (((_flag0 & 0x8000000u) != 0) && key=="owin.RequestUser")
+                    {
+                        value = RequestUser;
+                        return true;
+                    }
+                    if (((_flag0 & 0x20000000u) != 0) && key=="host.TraceOutput")
+                    {
+                        value = HostTraceOutput;
+                        return true;
+                    }
                    break;
                 case 23:
                     if (((_flag0 & 0x80u) != 0) && key=="owin.RequestQueryString")
@@ -873,6 +1135,11 @@ private bool PropertiesTryGetValue(string key, out object value)
                         value = ServerCapabilities;
                         return true;
                     }
+                    if (((_flag1 & 0x1u) != 0) && key=="host.OnAppDisposing")
+                    {
+                        value = HostOnAppDisposing;
+                        return true;
+                    }
                    break;
                 case 25:
                     if (((_flag0 & 0x800u) != 0) && key=="owin.ResponseReasonPhrase")
@@ -909,6 +1176,11 @@ private bool PropertiesTryGetValue(string key, out object value)
                         value = ServerLocalIpAddress;
                         return true;
                     }
+                    if (((_flag0 & 0x2000000u) != 0) && key=="owin.ResponseProtocol")
+                    {
+                        value = ResponseProtocol;
+                        return true;
+                    }
                    break;
                 case 22:
                     if (((_flag0 & 0x40000u) != 0) && key=="server.RemoteIpAddress")
@@ -923,6 +1195,18 @@ private bool PropertiesTryGetValue(string key, out object value)
                         value = ServerIsLocal;
                         return true;
                     }
+                    if (((_flag0 & 0x4000000u) != 0) && key=="owin.RequestId")
+                    {
+                        value = RequestId;
+                        return true;
+                    }
+                   break;
+                case 11:
+                    if (((_flag0 & 0x10000000u) != 0) && key=="server.User")
+                    {
+                        value = ServerUser;
+                        return true;
+                    }
                    break;
             }
             value = null;
@@ -939,6 +1223,16 @@ private bool PropertiesTrySetValue(string key, object value)
                         OwinVersion = value;
                         return true;
                     }
+                    if (key=="host.AppName")
+                    {
+                        HostAppName = value;
+                        return true;
+                    }
+                    if (key=="host.AppMode")
+                    {
+                        HostAppMode = value;
+                        return true;
+                    }
                    break;
                 case 18:
                     if (key=="owin.CallCancelled")
@@ -956,6 +1250,11 @@ private bool PropertiesTrySetValue(string key, object value)
                         RequestScheme = value;
                         return true;
                     }
+                    if (key=="sendfile.SendAsync")
+                    {
+                        SendFileAsync = value;
+                        return true;
+                    }
                    break;
                 case 20:
                     if (key=="owin.RequestProtocol")
@@ -995,6 +1294,16 @@ private bool PropertiesTrySetValue(string key, object value)
                         WebSocketAcceptFunc = value;
                         return true;
                     }
+                    if (key=="owin.RequestUser")
+                    {
+                        RequestUser = value;
+                        return true;
+                    }
+                    if (key=="host.TraceOutput")
+                    {
+                        HostTraceOutput = value;
+                        return true;
+                    }
                    break;
                 case 23:
                     if (key=="owin.RequestQueryString")
@@ -1024,6 +1333,11 @@ private bool PropertiesTrySetValue(string key, object value)
                         ServerCapabilities = value;
                         return true;
                     }
+                    if (key=="host.OnAppDisposing")
+                    {
+                        HostOnAppDisposing = value;
+                        return true;
+                    }
                    break;
                 case 25:
                     if (key=="owin.ResponseReasonPhrase")
@@ -1060,6 +1374,11 @@ private bool PropertiesTrySetValue(string key, object value)
                         ServerLocalIpAddress = value;
                         return true;
                     }
+                    if (key=="owin.ResponseProtocol")
+                    {
+                        ResponseProtocol = value;
+                        return true;
+                    }
                    break;
                 case 22:
                     if (key=="server.RemoteIpAddress")
@@ -1074,6 +1393,18 @@ private bool PropertiesTrySetValue(string key, object value)
                         ServerIsLocal = value;
                         return true;
                     }
+                    if (key=="owin.RequestId")
+                    {
+                        RequestId = value;
+                        return true;
+                    }
+                   break;
+                case 11:
+                    if (key=="server.User")
+                    {
+                        ServerUser = value;
+                        return true;
+                    }
                    break;
             }
             return false;
@@ -1090,6 +1421,18 @@ private bool PropertiesTryRemove(string key)
                         _OwinVersion = null;
                         return true;
                     }
+                    if (((_flag0 & 0x40000000u) != 0) && key=="host.AppName")
+                    {
+                        _flag0 &= ~0x40000000u;
+                        _HostAppName = null;
+                        return true;
+                    }
+                    if (((_flag0 & 0x80000000u) != 0) && key=="host.AppMode")
+                    {
+                        _flag0 &= ~0x80000000u;
+                        _HostAppMode = null;
+                        return true;
+                    }
                    break;
                 case 18:
                     if (((_flag0 & 0x2u) != 0) && key=="owin.CallCancelled")
@@ -1110,6 +1453,12 @@ private bool PropertiesTryRemove(string key)
                         _RequestScheme = null;
                         return true;
                     }
+                    if (((_flag0 & 0x1000000u) != 0) && key=="sendfile.SendAsync")
+                    {
+                        _flag0 &= ~0x1000000u;
+                        _SendFileAsync = null;
+                        return true;
+                    }
                    break;
                 case 20:
                     if (((_flag0 & 0x4u) != 0) && key=="owin.RequestProtocol")
@@ -1156,6 +1505,18 @@ private bool PropertiesTryRemove(string key)
                         _WebSocketAcceptFunc = null;
                         return true;
                     }
+                    if (((_flag0 & 0x8000000u) != 0) && key=="owin.RequestUser")
+                    {
+                        _flag0 &= ~0x8000000u;
+                        _RequestUser = null;
+                        return true;
+                    }
+                    if (((_flag0 & 0x20000000u) != 0) && key=="host.TraceOutput")
+                    {
+                        _flag0 &= ~0x20000000u;
+                        _HostTraceOutput = null;
+                        return true;
+                    }
                    break;
                 case 23:
                     if (((_flag0 & 0x80u) != 0) && key=="owin.RequestQueryString")
@@ -1190,6 +1551,12 @@ private bool PropertiesTryRemove(string key)
                         _ServerCapabilities = null;
                         return true;
                     }
+                    if (((_flag1 & 0x1u) != 0) && key=="host.OnAppDisposing")
+                    {
+                        _flag1 &= ~0x1u;
+                        _HostOnAppDisposing = null;
+                        return true;
+                    }
                    break;
                 case 25:
                     if (((_flag0 & 0x800u) != 0) && key=="owin.ResponseReasonPhrase")
@@ -1232,6 +1599,12 @@ private bool PropertiesTryRemove(string key)
                         _ServerLocalIpAddress = null;
                         return true;
                     }
+                    if (((_flag0 & 0x2000000u) != 0) && key=="owin.ResponseProtocol")
+                    {
+                        _flag0 &= ~0x2000000u;
+                        _ResponseProtocol = null;
+                        return true;
+                    }
                    break;
                 case 22:
                     if (((_flag0 & 0x40000u) != 0) && key=="server.RemoteIpAddress")
@@ -1248,6 +1621,20 @@ private bool PropertiesTryRemove(string key)
                         _ServerIsLocal = null;
                         return true;
                     }
+                    if (((_flag0 & 0x4000000u) != 0) && key=="owin.RequestId")
+                    {
+                        _flag0 &= ~0x4000000u;
+                        _RequestId = null;
+                        return true;
+                    }
+                   break;
+                case 11:
+                    if (((_flag0 & 0x10000000u) != 0) && key=="server.User")
+                    {
+                        _flag0 &= ~0x10000000u;
+                        _ServerUser = null;
+                        return true;
+                    }
                    break;
             }
             return false;
@@ -1351,6 +1738,42 @@ private IEnumerable<string> PropertiesKeys()
             {
                 yield return "websocket.Accept";
             }
+            if (((_flag0 & 0x1000000u) != 0))
+            {
+                yield return "sendfile.SendAsync";
+            }
+            if (((_flag0 & 0x2000000u) != 0))
+            {
+                yield return "owin.ResponseProtocol";
+            }
+            if (((_flag0 & 0x4000000u) != 0))
+            {
+                yield return "owin.RequestId";
+            }
+            if (((_flag0 & 0x8000000u) != 0))
+            {
+                yield return "owin.RequestUser";
+            }
+            if (((_flag0 & 0x10000000u) != 0))
+            {
+                yield return "server.User";
+            }
+            if (((_flag0 & 0x20000000u) != 0))
+            {
+                yield return "host.TraceOutput";
+            }
+            if (((_flag0 & 0x40000000u) != 0))
+            {
+                yield return "host.AppName";
+            }
+            if (((_flag0 & 0x80000000u) != 0))
+            {
+                yield return "host.AppMode";
+            }
+            if (((_flag1 & 0x1u) != 0))
+            {
+                yield return "host.OnAppDisposing";
+            }
         }
 
         private IEnumerable<object> PropertiesValues()
@@ -1451,6 +1874,42 @@ private IEnumerable<object> PropertiesValues()
             {
                 yield return WebSocketAcceptFunc;
             }
+            if (((_flag0 & 0x1000000u) != 0))
+            {
+                yield return SendFileAsync;
+            }
+            if (((_flag0 & 0x2000000u) != 0))
+            {
+                yield return ResponseProtocol;
+            }
+            if (((_flag0 & 0x4000000u) != 0))
+            {
+                yield return RequestId;
+            }
+            if (((_flag0 & 0x8000000u) != 0))
+            {
+                yield return RequestUser;
+            }
+            if (((_flag0 & 0x10000000u) != 0))
+            {
+                yield return ServerUser;
+            }
+            if (((_flag0 & 0x20000000u) != 0))
+            {
+                yield return HostTraceOutput;
+            }
+            if (((_flag0 & 0x40000000u) != 0))
+            {
+                yield return HostAppName;
+            }
+            if (((_flag0 & 0x80000000u) != 0))
+            {
+                yield return HostAppMode;
+            }
+            if (((_flag1 & 0x1u) != 0))
+            {
+                yield return HostOnAppDisposing;
+            }
         }
 
         private IEnumerable<KeyValuePair<string, object>> PropertiesEnumerable()
@@ -1551,6 +2010,42 @@ private IEnumerable<object> PropertiesValues()
             {
                 yield return new KeyValuePair<string, object>("websocket.Accept", WebSocketAcceptFunc);
             }
+            if (((_flag0 & 0x1000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("sendfile.SendAsync", SendFileAsync);
+            }
+            if (((_flag0 & 0x2000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("owin.ResponseProtocol", ResponseProtocol);
+            }
+            if (((_flag0 & 0x4000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("owin.RequestId", RequestId);
+            }
+            if (((_flag0 & 0x8000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("owin.RequestUser", RequestUser);
+            }
+            if (((_flag0 & 0x10000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("server.User", ServerUser);
+            }
+            if (((_flag0 & 0x20000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("host.TraceOutput", HostTraceOutput);
+            }
+            if (((_flag0 & 0x40000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("host.AppName", HostAppName);
+            }
+            if (((_flag0 & 0x80000000u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("host.AppMode", HostAppMode);
+            }
+            if (((_flag1 & 0x1u) != 0))
+            {
+                yield return new KeyValuePair<string, object>("host.OnAppDisposing", HostOnAppDisposing);
+            }
         }
     }
 }
@@ -13,6 +13,8 @@ sealed partial class OwinEnvironment : IDictionary<string, object>
 
         static readonly IDictionary<string, object> WeakNilEnvironment = new NilDictionary();
         IDictionary<string, object> _extra;
+        // Kept for whole connection life, so keep-alive requests with custom keys don't allocate new dictionary every time
+        Dictionary<string, object> _extraStorage;
 
         public OwinEnvironment(OwinHandler handler)
         {
@@ -22,7 +24,11 @@ public OwinEnvironment(OwinHandler handler)
         public void Reset()
         {
             _callback = _handler.Callback;
-            _extra = WeakNilEnvironment;
+            if (_extra != WeakNilEnvironment)
+            {
+                _extraStorage?.Clear();
+                _extra = WeakNilEnvironment;
+            }
             PropertiesReset();
         }
 
@@ -34,7 +40,9 @@ public void Reset()
             {
                 if (_extra == WeakNilEnvironment)
                 {
-                    Interlocked.CompareExchange(ref _extra, new Dictionary<string, object>(), WeakNilEnvironment);
+                    if (_extraStorage == null)
+                        Interlocked.CompareExchange(ref _extraStorage, new Dictionary<string, object>(), null);
+                    Interlocked.CompareExchange(ref _extra, _extraStorage, WeakNilEnvironment);
                 }
                 return _extra;
             }
@@ -39,6 +39,7 @@ namespace Nowin
             bool /* endOfMessage */,
             int /* count */
         >;
+    using SendFileFunc = Func<string /* filePath */, long /* offset */, long? /* byteCount */, CancellationToken /* cancel */, Task>;
     using WebSocketCloseAsync =
         Func
         <
@@ -55,7 +56,7 @@ public class OwinHandler : IHttpLayerHandler
         readonly int _handlerId;
 
         readonly OwinEnvironment _environment;
-        internal readonly Dictionary<string, string[]> ReqHeaders;
+        internal readonly RequestHeaderDictionary ReqHeaders;
         internal readonly Dictionary<string, string[]> RespHeaders;
         IDictionary<string, string[]> _overwrittenResponseHeaders;
         bool _inWebSocket;
@@ -96,11 +97,11 @@ enum WebSocketReceiveState
 
         public readonly Action<Action<object>, object> OnSendingHeadersAction;
         public readonly Action DisconnectAction;
+        public readonly SendFileFunc SendFileAsyncFunc;
+        public readonly WebSocketAccept WebSocketAcceptFunc;
 
         public IHttpLayerCallback Callback { set; internal get; }
 
-        public WebSocketAccept WebSocketAcceptFunc => WebSocketAcceptMethod;
-
         public object Capabilities => _owinCapabilities;
 
         public OwinHandler(OwinApp app, IDictionary<string, object> owinCapabilities, int handlerId)
@@ -109,9 +110,11 @@ public OwinHandler(OwinApp app, IDictionary<string, object> owinCapabilities, in
             _owinCapabilities = owinCapabilities;
             _handlerId = handlerId;
             _environment = new OwinEnvironment(this);
-            ReqHeaders = new Dictionary<string, string[]>(StringComparer.OrdinalIgnoreCase);
+            ReqHeaders = new RequestHeaderDictionary();
             RespHeaders = new Dictionary<string, string[]>(StringComparer.OrdinalIgnoreCase);
             OnSendingHeadersAction = OnSendingHeadersMethod;
+            SendFileAsyncFunc = SendFileAsyncMethod;
+            WebSocketAcceptFunc = WebSocketAcceptMethod;
             _webSocketEnv = new Dictionary<string, object>
                 {
                     {"websocket.SendAsync", (WebSocketSendAsync) WebSocketSendAsyncMethod},
@@ -143,6 +146,11 @@ void ReportFinishOfAppFunc()
             _lastRequestFinished?.SetResult(true);
         }
 
+        Task SendFileAsyncMethod(string fileName, long offset, long? count, CancellationToken cancel)
+        {
+            return Callback.SendFileAsync(fileName, offset, count, cancel);
+        }
+
         void OnSendingHeadersMethod(Action<object> action, object state)
         {
             if (Callback.HeadersSend) throw new InvalidOperationException("Headers already sent");
@@ -173,17 +181,7 @@ public void PrepareForRequest()
 
         public void AddRequestHeader(string name, string value)
         {
-            string[] values;
-            if (ReqHeaders.TryGetValue(name, out values))
-            {
-                Array.Resize(ref values, values.Length + 1);
-                values[values.Length - 1] = value;
-                ReqHeaders[name] = values;
-            }
-            else
-            {
-                ReqHeaders.Add(name, new[] { value });
-            }
+            ReqHeaders.AddParsed(name, value);
         }
 
         public void HandleRequest()
@@ -290,16 +288,31 @@ public void PrepareResponseHeaders()
                 Callback.ResponseContentLength = temp;
             }
             headers.Remove("Transfer-Encoding");
-            foreach (var header in headers)
+            var dictionary = headers as Dictionary<string, string[]>;
+            if (dictionary != null)
             {
-                if (header.Value.Length == 1)
-                {
-                    Callback.AddResponseHeader(header.Key, header.Value[0]);
-                }
-                else
+                // Struct enumerator, avoids boxing on every response
+                foreach (var header in dictionary)
                 {
-                    Callback.AddResponseHeader(header.Key, header.Value);
+                    AddResponseHeader(header.Key, header.Value);
                 }
+                return;
+            }
+            foreach (var header in headers)
+            {
+                AddResponseHeader(header.Key, header.Value);
+            }
+        }
+
+        void AddResponseHeader(string name, string[] values)
+        {
+            if (values.Length == 1)
+            {
+                Callback.AddResponseHeader(name, values[0]);
+            }
+            else
+            {
+                Callback.AddResponseHeader(name, values);
             }
         }
 
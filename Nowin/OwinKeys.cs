@@ -31,5 +31,9 @@ public static class OwinKeys
 
         public const string WebSocketVersionKey = "websocket.Version";
         public const string WebSocketVersion = "1.0";
+
+        public const string SendFileAsync = "sendfile.SendAsync";
+        public const string SendFileVersionKey = "sendfile.Version";
+        public const string SendFileVersion = "1.0";
     }
 }
\ No newline at end of file
@@ -25,6 +25,7 @@ public static void Initialize(IDictionary<string, object> properties)
 
             capabilities[OwinKeys.ServerNameKey] = "Nowin";
             capabilities[OwinKeys.WebSocketVersionKey] = OwinKeys.WebSocketVersion;
+            capabilities[OwinKeys.SendFileVersionKey] = OwinKeys.SendFileVersion;
         }
 
         public static IDisposable Create(Func<IDictionary<string, object>, Task> app, IDictionary<string, object> properties)
@@ -1,4 +1,5 @@
 ﻿using System.Reflection;
+using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 
 // General Information about an assembly is controlled through the following 
@@ -18,6 +19,9 @@
 // COM, set the ComVisible attribute to true on that type.
 [assembly: ComVisible(false)]
 
+[assembly: InternalsVisibleTo("NowinTests")]
+[assembly: InternalsVisibleTo("NowinBenchmark")]
+
 // The following GUID is for the ID of the typelib if this project is exposed to COM
 [assembly: Guid("fd085b68-3766-42af-ab6d-351b7741c685")]
 
@@ -15,6 +15,8 @@ class ReqRespStream : Stream
         int _asyncOffset;
         int _asyncCount;
         int _asyncResult;
+        // Synchronously completed reads mostly return same count (full buffer or same sized body), so completed task can be reused
+        Task<int> _lastCompletedRead;
         ChunkedDecoder _chunkedDecoder = new ChunkedDecoder();
 
         internal readonly int ResponseStartOffset;
@@ -53,10 +55,21 @@ public override int Read(byte[] buffer, int offset, int count)
         public override Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken)
         {
             ReadSyncPart(buffer, offset, count);
-            if (_asyncCount == 0) return Task.FromResult(_asyncResult);
+            if (_asyncCount == 0) return CompletedRead(_asyncResult);
             return ReadOverflowAsync();
         }
 
+        Task<int> CompletedRead(int result)
+        {
+            var task = _lastCompletedRead;
+            if (task == null || task.Result != result)
+            {
+                task = Task.FromResult(result);
+                _lastCompletedRead = task;
+            }
+            return task;
+        }
+
         void ReadSyncPart(byte[] buffer, int offset, int count)
         {
             if (RequestPosition == 0 && _transport2HttpHandler.ShouldSend100Continue)
@@ -229,17 +242,20 @@ public override Task WriteAsync(byte[] buffer, int offset, int count, Cancellati
 
         async Task WriteOverflowAsync(byte[] buffer, int offset, int count)
         {
+            if (count >= _responseMaxLen)
+            {
+                // Send already buffered part together with caller buffer in one gather send, no copying
+                var buffered = ResponseLocalPos;
+                ResponseLocalPos = 0;
+                _responsePosition += (ulong)count;
+                await _transport2HttpHandler.WriteGatherAsync(buffered, buffer, offset, count);
+                return;
+            }
             do
             {
                 if (ResponseLocalPos == _responseMaxLen)
                 {
                     await FlushAsyncCore();
-                    if ((count >= _responseMaxLen) && _transport2HttpHandler.CanUseDirectWrite())
-                    {
-                        _responsePosition += (ulong)count;
-                        await _transport2HttpHandler.WriteAsync(buffer, offset, count);
-                        return;
-                    }
                 }
                 var tillEnd = _responseMaxLen - ResponseLocalPos;
                 if (tillEnd > count) tillEnd = count;
@@ -250,5 +266,43 @@ async Task WriteOverflowAsync(byte[] buffer, int offset, int count)
                 count -= tillEnd;
             } while (count > 0);
         }
+
+        public async Task SendFileAsync(string fileName, long offset, long? count, CancellationToken cancel)
+        {
+            cancel.ThrowIfCancellationRequested();
+            var fileLength = new FileInfo(fileName).Length;
+            if (offset < 0 || offset > fileLength)
+                throw new ArgumentOutOfRangeException(nameof(offset), offset, "Offset is outside of file");
+            var len = count ?? fileLength - offset;
+            if (len < 0 || len > fileLength - offset)
+                throw new ArgumentOutOfRangeException(nameof(count), count, "Count is outside of file");
+            if (len == 0) return;
+            if (offset + len > int.MaxValue)
+            {
+                // SendPacketsElement supports only int offsets
+                await CopyFileAsync(fileName, offset, len, cancel);
+                return;
+            }
+            var buffered = ResponseLocalPos;
+            ResponseLocalPos = 0;
+            _responsePosition += (ulong)len;
+            await _transport2HttpHandler.WriteFileAsync(buffered, fileName, offset, len);
+        }
+
+        async Task CopyFileAsync(string fileName, long offset, long count, CancellationToken cancel)
+        {
+            using (var file = new FileStream(fileName, FileMode.Open, FileAccess.Read, FileShare.Read, 4096, true))
+            {
+                file.Position = offset;
+                var buffer = new byte[_responseMaxLen];
+                while (count > 0)
+                {
+                    var read = await file.ReadAsync(buffer, 0, (int)Math.Min(buffer.Length, count), cancel);
+                    if (read == 0) throw new EndOfStreamException();
+                    await WriteAsync(buffer, 0, read, cancel);
+                    count -= read;
+                }
+            }
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+namespace Nowin
+{
+    // Scans request head 8 bytes at once using SWAR (SIMD within a register) tricks and falls back to byte by byte only inside word which contains match.
+    // Functions which does not take end parameter rely on request head being already terminated by CRLFCRLF so they always find CR.
+    static unsafe class RequestHeadScanner
+    {
+        const ulong Ones = 0x0101010101010101UL;
+        const ulong Highs = 0x8080808080808080UL;
+        const ulong Crs = Ones * 13;
+        const ulong Lfs = Ones * 10;
+        const ulong Spaces = Ones * ' ';
+        const ulong Colons = Ones * ':';
+        const ulong QuestionMarks = Ones * '?';
+
+        // Nonzero if any byte in word is zero. Only lowest flagged byte is exact, but we always rescan flagged word byte by byte.
+        static ulong HasZeroByte(ulong word)
+        {
+            return (word - Ones) & ~word & Highs;
+        }
+
+        // Nonzero if any byte in word is less than n (n <= 128).
+        static ulong HasByteLessThan(ulong word, ulong n)
+        {
+            return (word - Ones * n) & ~word & Highs;
+        }
+
+        /// <returns>position just after CRLFCRLF or -1 if not found in [start, end)</returns>
+        internal static int FindRequestEnd(byte[] buffer, int start, int end)
+        {
+            if (end - start < 4) return -1;
+            fixed (byte* b = buffer)
+            {
+                // LF could be only at start+3 or later, we look for LF and check 3 preceding bytes
+                var pos = start + 3;
+                while (pos + 8 <= end)
+                {
+                    if (HasZeroByte(*(ulong*)(b + pos) ^ Lfs) != 0)
+                    {
+                        for (var i = pos; i < pos + 8; i++)
+                        {
+                            if (b[i] == 10 && b[i - 1] == 13 && b[i - 2] == 10 && b[i - 3] == 13) return i + 1;
+                        }
+                    }
+                    pos += 8;
+                }
+                while (pos < end)
+                {
+                    if (b[pos] == 10 && b[pos - 1] == 13 && b[pos - 2] == 10 && b[pos - 3] == 13) return pos + 1;
+                    pos++;
+                }
+            }
+            return -1;
+        }
+
+        internal static void SkipToCR(byte[] buffer, ref int pos)
+        {
+            var len = buffer.Length;
+            fixed (byte* b = buffer)
+            {
+                var p = pos;
+                while (p + 8 <= len && HasZeroByte(*(ulong*)(b + p) ^ Crs) == 0)
+                {
+                    p += 8;
+                }
+                while (b[p] != 13) p++;
+                pos = p;
+            }
+        }
+
+        // Token ends with control character, space or colon
+        internal static void SkipTokenChars(byte[] buffer, ref int pos)
+        {
+            var len = buffer.Length;
+            fixed (byte* b = buffer)
+            {
+                var p = pos;
+                while (p + 8 <= len)
+                {
+                    var word = *(ulong*)(b + p);
+                    if ((HasByteLessThan(word, 33) | HasZeroByte(word ^ Colons)) != 0) break;
+                    p += 8;
+                }
+                while (true)
+                {
+                    var ch = b[p];
+                    if (ch <= 32 || ch == ':') break;
+                    p++;
+                }
+                pos = p;
+            }
+        }
+
+        internal static byte SearchForFirstSpaceOrEndOfLine(byte[] buffer, ref int pos)
+        {
+            var len = buffer.Length;
+            fixed (byte* b = buffer)
+            {
+                var p = pos;
+                while (p + 8 <= len)
+                {
+                    var word = *(ulong*)(b + p);
+                    if ((HasZeroByte(word ^ Spaces) | HasZeroByte(word ^ Crs)) != 0) break;
+                    p += 8;
+                }
+                while (true)
+                {
+                    var ch = b[p];
+                    if (ch == ' ' || ch == 13)
+                    {
+                        pos = p;
+                        return ch;
+                    }
+                    p++;
+                }
+            }
+        }
+
+        internal static byte SearchForFirstSpaceOrQuestionMarkOrEndOfLine(byte[] buffer, ref int pos)
+        {
+            var len = buffer.Length;
+            fixed (byte* b = buffer)
+            {
+                var p = pos;
+                while (p + 8 <= len)
+                {
+                    var word = *(ulong*)(b + p);
+                    if ((HasZeroByte(word ^ Spaces) | HasZeroByte(word ^ QuestionMarks) | HasZeroByte(word ^ Crs)) != 0) break;
+                    p += 8;
+                }
+                while (true)
+                {
+                    var ch = b[p];
+                    if (ch == ' ' || ch == '?' || ch == 13)
+                    {
+                        pos = p;
+                        return ch;
+                    }
+                    p++;
+                }
+            }
+        }
+
+        internal static bool EqualsLatin1(string value, byte[] buffer, int start)
+        {
+            var len = value.Length;
+            fixed (byte* b = buffer)
+            {
+                var p = b + start;
+                for (var i = 0; i < len; i++)
+                {
+                    if (value[i] != p[i]) return false;
+                }
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,160 @@
+using System;
+using System.Collections;
+using System.Collections.Generic;
+
+namespace Nowin
+{
+    // Parser stores single header values without array, array is created only when application asks for that header.
+    // Every created array belongs to current request only, so application can keep or modify it.
+    class RequestHeaderDictionary : IDictionary<string, string[]>
+    {
+        readonly Dictionary<string, string[]> _arrays = new Dictionary<string, string[]>(StringComparer.OrdinalIgnoreCase);
+        // Value is name as parsed together with header value, lookup key could differ in case
+        readonly Dictionary<string, KeyValuePair<string, string>> _singles = new Dictionary<string, KeyValuePair<string, string>>(StringComparer.OrdinalIgnoreCase);
+
+        internal void AddParsed(string name, string value)
+        {
+            KeyValuePair<string, string> single;
+            if (_singles.TryGetValue(name, out single))
+            {
+                _singles.Remove(name);
+                _arrays.Add(single.Key, new[] { single.Value, value });
+                return;
+            }
+            string[] values;
+            if (_arrays.TryGetValue(name, out values))
+            {
+                Array.Resize(ref values, values.Length + 1);
+                values[values.Length - 1] = value;
+                _arrays[name] = values;
+                return;
+            }
+            _singles.Add(name, new KeyValuePair<string, string>(name, value));
+        }
+
+        string[] Materialize(KeyValuePair<string, string> single)
+        {
+            var values = new[] { single.Value };
+            _singles.Remove(single.Key);
+            _arrays.Add(single.Key, values);
+            return values;
+        }
+
+        void MaterializeAll()
+        {
+            if (_singles.Count == 0) return;
+            foreach (var single in _singles.Values)
+            {
+                _arrays.Add(single.Key, new[] { single.Value });
+            }
+            _singles.Clear();
+        }
+
+        public bool TryGetValue(string key, out string[] value)
+        {
+            if (_arrays.TryGetValue(key, out value)) return true;
+            KeyValuePair<string, string> single;
+            if (!_singles.TryGetValue(key, out single)) return false;
+            value = Materialize(single);
+            return true;
+        }
+
+        public string[] this[string key]
+        {
+            get
+            {
+                string[] values;
+                if (!TryGetValue(key, out values)) throw new KeyNotFoundException();
+                return values;
+            }
+            set
+            {
+                KeyValuePair<string, string> single;
+                if (_singles.TryGetValue(key, out single))
+                {
+                    _singles.Remove(key);
+                    key = single.Key;
+                }
+                _arrays[key] = value;
+            }
+        }
+
+        public bool ContainsKey(string key)
+        {
+            return _arrays.ContainsKey(key) || _singles.ContainsKey(key);
+        }
+
+        public void Add(string key, string[] value)
+        {
+            if (_singles.ContainsKey(key)) throw new ArgumentException("An item with the same key has already been added.");
+            _arrays.Add(key, value);
+        }
+
+        public bool Remove(string key)
+        {
+            return _singles.Remove(key) || _arrays.Remove(key);
+        }
+
+        public ICollection<string> Keys
+        {
+            get
+            {
+                MaterializeAll();
+                return _arrays.Keys;
+            }
+        }
+
+        public ICollection<string[]> Values
+        {
+            get
+            {
+                MaterializeAll();
+                return _arrays.Values;
+            }
+        }
+
+        public int Count => _arrays.Count + _singles.Count;
+
+        public bool IsReadOnly => false;
+
+        public void Add(KeyValuePair<string, string[]> item)
+        {
+            Add(item.Key, item.Value);
+        }
+
+        public void Clear()
+        {
+            _arrays.Clear();
+            _singles.Clear();
+        }
+
+        public bool Contains(KeyValuePair<string, string[]> item)
+        {
+            MaterializeAll();
+            return ((ICollection<KeyValuePair<string, string[]>>)_arrays).Contains(item);
+        }
+
+        public void CopyTo(KeyValuePair<string, string[]>[] array, int arrayIndex)
+        {
+            MaterializeAll();
+            ((ICollection<KeyValuePair<string, string[]>>)_arrays).CopyTo(array, arrayIndex);
+        }
+
+        public bool Remove(KeyValuePair<string, string[]> item)
+        {
+            MaterializeAll();
+            return ((ICollection<KeyValuePair<string, string[]>>)_arrays).Remove(item);
+        }
+
+        public IEnumerator<KeyValuePair<string, string[]>> GetEnumerator()
+        {
+            MaterializeAll();
+            return _arrays.GetEnumerator();
+        }
+
+        IEnumerator IEnumerable.GetEnumerator()
+        {
+            return GetEnumerator();
+        }
+    }
+}
@@ -0,0 +1,176 @@
+using System;
+using System.Collections.Generic;
+using System.Threading.Tasks;
+
+namespace Nowin
+{
+    // Shared by all connections of server. Bounded by total size of stored responses, least recently used are evicted first.
+    class ResponseCache
+    {
+        readonly long _maxSize;
+        internal readonly int MaxEntrySize;
+        internal readonly bool CacheRequestsWithCookies;
+        readonly object _lock = new object();
+        readonly Dictionary<ResponseCacheKey, ResponseCacheEntry> _entries = new Dictionary<ResponseCacheKey, ResponseCacheEntry>();
+        // Keys which some connection is just getting from application, other requests for them wait instead of calling application too
+        readonly Dictionary<ResponseCacheKey, Fill> _fills = new Dictionary<ResponseCacheKey, Fill>();
+        // Application slower than this is called also by waiting requests, so they are not stuck behind it
+        static readonly TimeSpan FillWaitTimeout = TimeSpan.FromSeconds(10);
+        // Most recently used
+        ResponseCacheEntry _lruHead;
+        ResponseCacheEntry _lruTail;
+        long _size;
+
+        internal ResponseCache(long maxSize, int maxEntrySize, bool cacheRequestsWithCookies)
+        {
+            _maxSize = maxSize;
+            MaxEntrySize = maxEntrySize;
+            CacheRequestsWithCookies = cacheRequestsWithCookies;
+        }
+
+        internal ResponseCacheEntry Lookup(ResponseCacheKey key, ResponseCacheHandler request, int now)
+        {
+            lock (_lock)
+            {
+                ResponseCacheEntry entry;
+                if (!_entries.TryGetValue(key, out entry)) return null;
+                while (entry != null && !VaryMatches(entry, request))
+                    entry = entry.NextVariant;
+                if (entry == null) return null;
+                if (!entry.IsFresh(now))
+                {
+                    Remove(entry);
+                    return null;
+                }
+                MoveToLruHead(entry);
+                return entry;
+            }
+        }
+
+        static bool VaryMatches(ResponseCacheEntry entry, ResponseCacheHandler request)
+        {
+            for (var i = 0; i < entry.VaryNames.Length; i++)
+            {
+                if (!string.Equals(request.GetRequestHeader(entry.VaryNames[i]), entry.VaryValues[i], StringComparison.Ordinal))
+                    return false;
+            }
+            return true;
+        }
+
+        // Returns null when caller should get response from application and call EndFill afterwards,
+        // otherwise returns task completed when other connection finishes filling same key or waiting times out.
+        internal Task StartFillOrWait(ResponseCacheKey key)
+        {
+            lock (_lock)
+            {
+                Fill fill;
+                if (_fills.TryGetValue(key, out fill))
+                {
+                    // One timeout shared by all requests waiting on same fill
+                    return fill.Wait ?? (fill.Wait = Task.WhenAny(fill.Completion.Task, Task.Delay(FillWaitTimeout)));
+                }
+                _fills.Add(key, new Fill());
+                return null;
+            }
+        }
+
+        internal void EndFill(ResponseCacheKey key)
+        {
+            Fill fill;
+            lock (_lock)
+            {
+                if (!_fills.TryGetValue(key, out fill)) return;
+                _fills.Remove(key);
+            }
+            // Continuations of waiting requests must not run under lock
+            fill.Completion.TrySetResult(true);
+        }
+
+        internal void Store(ResponseCacheEntry entry)
+        {
+            if (entry.Size > _maxSize) return;
+            lock (_lock)
+            {
+                ResponseCacheEntry first;
+                if (_entries.TryGetValue(entry.Key, out first))
+                {
+                    for (var variant = first; variant != null; variant = variant.NextVariant)
+                    {
+                        if (!SameVariant(variant, entry)) continue;
+                        Remove(variant);
+                        break;
+                    }
+                }
+                if (_entries.TryGetValue(entry.Key, out first))
+                {
+                    entry.NextVariant = first;
+                }
+                _entries[entry.Key] = entry;
+                entry.LruNext = _lruHead;
+                if (_lruHead != null) _lruHead.LruPrev = entry;
+                _lruHead = entry;
+                if (_lruTail == null) _lruTail = entry;
+                _size += entry.Size;
+                while (_size > _maxSize)
+                    Remove(_lruTail);
+            }
+        }
+
+        static bool SameVariant(ResponseCacheEntry a, ResponseCacheEntry b)
+        {
+            if (a.VaryNames.Length != b.VaryNames.Length) return false;
+            for (var i = 0; i < a.VaryNames.Length; i++)
+            {
+                if (!string.Equals(a.VaryNames[i], b.VaryNames[i], StringComparison.OrdinalIgnoreCase)) return false;
+                if (!string.Equals(a.VaryValues[i], b.VaryValues[i], StringComparison.Ordinal)) return false;
+            }
+            return true;
+        }
+
+        void MoveToLruHead(ResponseCacheEntry entry)
+        {
+            if (entry == _lruHead) return;
+            UnlinkLru(entry);
+            entry.LruNext = _lruHead;
+            _lruHead.LruPrev = entry;
+            _lruHead = entry;
+        }
+
+        void UnlinkLru(ResponseCacheEntry entry)
+        {
+            if (entry.LruPrev != null) entry.LruPrev.LruNext = entry.LruNext;
+            else _lruHead = entry.LruNext;
+            if (entry.LruNext != null) entry.LruNext.LruPrev = entry.LruPrev;
+            else _lruTail = entry.LruPrev;
+            entry.LruPrev = null;
+            entry.LruNext = null;
+        }
+
+        void Remove(ResponseCacheEntry entry)
+        {
+            UnlinkLru(entry);
+            _size -= entry.Size;
+            var first = _entries[entry.Key];
+            if (first == entry)
+            {
+                if (entry.NextVariant != null)
+                    _entries[entry.Key] = entry.NextVariant;
+                else
+                    _entries.Remove(entry.Key);
+            }
+            else
+            {
+                while (first.NextVariant != entry)
+                    first = first.NextVariant;
+                first.NextVariant = entry.NextVariant;
+            }
+            entry.NextVariant = null;
+        }
+
+        class Fill
+        {
+            internal readonly TaskCompletionSource<bool> Completion = new TaskCompletionSource<bool>();
+            internal Task Wait;
+        }
+    }
+}
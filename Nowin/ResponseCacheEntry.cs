@@ -0,0 +1,45 @@
+namespace Nowin
+{
+    // Immutable after it is stored, so it could be sent by many connections at once
+    class ResponseCacheEntry
+    {
+        internal readonly ResponseCacheKey Key;
+        // Request header names from response Vary header and their values in request which filled entry
+        internal readonly string[] VaryNames;
+        internal readonly string[] VaryValues;
+        // Status line and headers without Date and final CRLF
+        internal readonly byte[] Head;
+        internal readonly byte[] Body;
+        internal readonly int StoredAt;
+        internal readonly int MaxAgeMilliseconds;
+        internal readonly long Size;
+
+        // Guarded by ResponseCache lock
+        internal ResponseCacheEntry NextVariant;
+        internal ResponseCacheEntry LruPrev;
+        internal ResponseCacheEntry LruNext;
+
+        internal ResponseCacheEntry(ResponseCacheKey key, string[] varyNames, string[] varyValues, byte[] head, byte[] body, int storedAt, int maxAgeMilliseconds)
+        {
+            Key = key;
+            VaryNames = varyNames;
+            VaryValues = varyValues;
+            Head = head;
+            Body = body;
+            StoredAt = storedAt;
+            MaxAgeMilliseconds = maxAgeMilliseconds;
+            // Rough estimate of object and key overhead
+            Size = head.Length + body.Length + 256;
+        }
+
+        internal bool IsFresh(int now)
+        {
+            return unchecked(now - StoredAt) < MaxAgeMilliseconds;
+        }
+
+        internal int AgeInSeconds(int now)
+        {
+            return unchecked(now - StoredAt) / 1000;
+        }
+    }
+}
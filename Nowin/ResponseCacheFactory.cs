@@ -0,0 +1,35 @@
+namespace Nowin
+{
+    public class ResponseCacheFactory : ILayerFactory
+    {
+        readonly ILayerFactory _next;
+        readonly ResponseCache _cache;
+        readonly string _serverName;
+        readonly ServerMetrics _metrics;
+
+        // Responses to requests with Cookie often depend on it without saying so in Vary, such requests bypass cache
+        // unless cacheRequestsWithCookies is set
+        public ResponseCacheFactory(ILayerFactory next, long maxSize, int maxEntrySize, string serverName, ServerMetrics metrics = null, bool cacheRequestsWithCookies = false)
+        {
+            _next = next;
+            _cache = new ResponseCache(maxSize, maxEntrySize, cacheRequestsWithCookies);
+            _serverName = serverName;
+            _metrics = metrics;
+        }
+
+        public int PerConnectionBufferSize => _next.PerConnectionBufferSize;
+
+        public int CommonBufferSize => _next.CommonBufferSize;
+
+        public void InitCommonBuffer(byte[] buffer, int offset)
+        {
+            _next.InitCommonBuffer(buffer, offset);
+        }
+
+        public ILayerHandler Create(byte[] buffer, int offset, int commonOffset, int handlerId)
+        {
+            var nextHandler = (IHttpLayerHandler)_next.Create(buffer, offset, commonOffset, handlerId);
+            return new ResponseCacheHandler(nextHandler, _cache, _serverName, _metrics);
+        }
+    }
+}
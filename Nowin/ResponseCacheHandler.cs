@@ -0,0 +1,539 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+using System.Security.Cryptography.X509Certificates;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Nowin
+{
+    // Sits between Transport2HttpHandler and OwinHandler. Request headers are only buffered, so cache hit is sent
+    // without preparing OWIN environment. Misses are passed to application and its response is captured when cacheable.
+    class ResponseCacheHandler : IHttpLayerHandler, IHttpLayerCallback
+    {
+        readonly IHttpLayerHandler _next;
+        readonly ResponseCache _cache;
+        readonly string _serverName;
+        readonly ServerMetrics _metrics;
+        readonly List<KeyValuePair<string, string>> _requestHeaders = new List<KeyValuePair<string, string>>();
+        readonly List<KeyValuePair<string, string>> _responseHeaders = new List<KeyValuePair<string, string>>();
+        IHttpLayerCallback _callback;
+        ResponseCaptureStream _captureStream;
+        ResponseCacheKey _key;
+        bool _bypass;
+        // This connection gets response from application for other connections waiting on same key
+        bool _filling;
+        bool _capturing;
+        bool _responseHeadersCaptured;
+        bool _finishing;
+        string _reasonPhase;
+        ulong _responseContentLength;
+        // Request waiting for other connection filling same key, dropped when client disconnects or slot is recycled first
+        FillWait _fillWait;
+
+        sealed class FillWait
+        {
+            internal readonly ResponseCacheHandler Handler;
+            // Completed after continuation finished or when wait was dropped before it started
+            internal readonly TaskCompletionSource<object> Finished = new TaskCompletionSource<object>();
+            internal CancellationTokenRegistration Disconnect;
+            int _claimed;
+
+            internal FillWait(ResponseCacheHandler handler)
+            {
+                Handler = handler;
+            }
+
+            // Only one of continuation and drop wins
+            internal bool Claim()
+            {
+                return Interlocked.Exchange(ref _claimed, 1) == 0;
+            }
+        }
+
+        internal ResponseCacheHandler(IHttpLayerHandler next, ResponseCache cache, string serverName, ServerMetrics metrics)
+        {
+            _next = next;
+            _cache = cache;
+            _serverName = serverName;
+            _metrics = metrics;
+            _next.Callback = this;
+        }
+
+        public IHttpLayerCallback Callback
+        {
+            set { _callback = value; }
+        }
+
+        public void Dispose()
+        {
+            DropFillWait();
+            EndFill();
+            _next.Dispose();
+        }
+
+        public Task WaitForFinishingLastRequest()
+        {
+            var running = DropFillWait();
+            EndFill();
+            if (running == null)
+                return _next.WaitForFinishingLastRequest();
+            return running.ContinueWith((t, o) => ((IHttpLayerHandler)o).WaitForFinishingLastRequest(), _next).Unwrap();
+        }
+
+        public void PrepareForRequest()
+        {
+            DropFillWait();
+            EndFill();
+            _requestHeaders.Clear();
+            _bypass = false;
+        }
+
+        public void AddRequestHeader(string name, string value)
+        {
+            _requestHeaders.Add(new KeyValuePair<string, string>(name, value));
+            // Requests with body or credentials are never served from cache, no-cache forces going to application
+            if (name.Equals("Authorization", StringComparison.OrdinalIgnoreCase)
+                || name.Equals("Cookie", StringComparison.OrdinalIgnoreCase) && !_cache.CacheRequestsWithCookies
+                || name.Equals("Transfer-Encoding", StringComparison.OrdinalIgnoreCase)
+                || name.Equals("Content-Length", StringComparison.OrdinalIgnoreCase) && value != "0"
+                || (name.Equals("Cache-Control", StringComparison.OrdinalIgnoreCase) || name.Equals("Pragma", StringComparison.OrdinalIgnoreCase))
+                && value.IndexOf("no-cache", StringComparison.OrdinalIgnoreCase) >= 0)
+            {
+                _bypass = true;
+            }
+        }
+
+        internal string GetRequestHeader(string name)
+        {
+            string result = null;
+            for (var i = 0; i < _requestHeaders.Count; i++)
+            {
+                var header = _requestHeaders[i];
+                if (!header.Key.Equals(name, StringComparison.OrdinalIgnoreCase)) continue;
+                result = result == null ? header.Value : result + "," + header.Value;
+            }
+            return result;
+        }
+
+        public void HandleRequest()
+        {
+            var method = _callback.RequestMethod;
+            var isGet = method == "GET";
+            if (_bypass || !isGet && method != "HEAD" || _callback.IsWebSocketReq)
+            {
+                Forward(false);
+                return;
+            }
+            // HEAD is answered from entry filled by GET
+            _key = new ResponseCacheKey(_callback.RequestScheme == "https", GetRequestHeader("Host"), "GET", _callback.RequestPath, _callback.RequestQueryString);
+            if (TrySendFromCache())
+                return;
+            if (!isGet)
+            {
+                CountMiss();
+                Forward(false);
+                return;
+            }
+            var fill = _cache.StartFillOrWait(_key);
+            if (fill == null)
+            {
+                _filling = true;
+                CountMiss();
+                Forward(true);
+                return;
+            }
+            if (fill.IsCompleted)
+            {
+                AfterFillWait();
+                return;
+            }
+            var wait = new FillWait(this);
+            _fillWait = wait;
+            wait.Disconnect = _callback.CallCancelled.Register(o => ((FillWait)o).Handler.DisconnectedWhileWaiting((FillWait)o), wait);
+            fill.ContinueWith((t, o) =>
+            {
+                var w = (FillWait)o;
+                if (!w.Claim()) return;
+                w.Disconnect.Dispose();
+                w.Handler.AfterFillWait();
+                w.Finished.TrySetResult(null);
+            }, wait);
+        }
+
+        // Nobody will read response, so connection is closed without waiting for fill
+        void DisconnectedWhileWaiting(FillWait wait)
+        {
+            if (!wait.Claim()) return;
+            wait.Finished.TrySetResult(null);
+            _callback.CloseConnection();
+        }
+
+        // Returns task of continuation which already started, null when there was nothing to wait for
+        Task DropFillWait()
+        {
+            var wait = _fillWait;
+            if (wait == null) return null;
+            _fillWait = null;
+            if (!wait.Claim())
+                return wait.Finished.Task.IsCompleted ? null : wait.Finished.Task;
+            wait.Disconnect.Dispose();
+            wait.Finished.TrySetResult(null);
+            return null;
+        }
+
+        void AfterFillWait()
+        {
+            try
+            {
+                if (TrySendFromCache())
+                    return;
+                CountMiss();
+                Forward(false);
+            }
+            catch (Exception ex)
+            {
+                TraceSources.Core.TraceEvent(System.Diagnostics.TraceEventType.Error, 0, "Response cache failed {0}", ex);
+                _callback.CloseConnection();
+            }
+        }
+
+        bool TrySendFromCache()
+        {
+            var now = Environment.TickCount;
+            var entry = _cache.Lookup(_key, this, now);
+            if (entry == null || !_callback.TrySendCachedResponse(entry.Head, entry.AgeInSeconds(now), entry.Body))
+                return false;
+            _metrics?.Increment(MetricsCounter.ResponseCacheHits);
+            return true;
+        }
+
+        void CountMiss()
+        {
+            _metrics?.Increment(MetricsCounter.ResponseCacheMisses);
+        }
+
+        void Forward(bool capture)
+        {
+            _next.PrepareForRequest();
+            for (var i = 0; i < _requestHeaders.Count; i++)
+            {
+                var header = _requestHeaders[i];
+                _next.AddRequestHeader(header.Key, header.Value);
+            }
+            _capturing = capture;
+            if (capture)
+            {
+                _responseHeaders.Clear();
+                _responseHeadersCaptured = false;
+                _finishing = false;
+                _reasonPhase = null;
+                _responseContentLength = ulong.MaxValue;
+                if (_captureStream == null)
+                    _captureStream = new ResponseCaptureStream(_callback.ReqRespBody, _cache.MaxEntrySize);
+                _captureStream.Reset();
+            }
+            _next.HandleRequest();
+        }
+
+        void AbandonCapture()
+        {
+            if (!_capturing) return;
+            _capturing = false;
+            _captureStream.Abandon();
+            EndFill();
+        }
+
+        void EndFill()
+        {
+            _capturing = false;
+            if (!_filling) return;
+            _filling = false;
+            _cache.EndFill(_key);
+        }
+
+        public void PrepareResponseHeaders()
+        {
+            _next.PrepareResponseHeaders();
+            if (!_capturing) return;
+            _responseHeadersCaptured = true;
+            if (!_finishing) return;
+            // Response without body is finished, store it before transport starts sending and recycles this handler
+            _finishing = false;
+            StoreCaptured();
+            EndFill();
+        }
+
+        public void UpgradedToWebSocket(bool success)
+        {
+            _next.UpgradedToWebSocket(success);
+        }
+
+        public void FinishReceiveData(bool success)
+        {
+            _next.FinishReceiveData(success);
+        }
+
+        void StoreCaptured()
+        {
+            var status = _callback.ResponseStatusCode;
+            if (status != 200 && status != 203 && status != 301 && status != 404 && status != 410) return;
+            if (!_captureStream.IsComplete) return;
+            var body = _captureStream.ToArray();
+            if (_responseContentLength != ulong.MaxValue && _responseContentLength != (ulong)body.Length) return;
+            string cacheControl = null;
+            string vary = null;
+            var hasServer = false;
+            for (var i = 0; i < _responseHeaders.Count; i++)
+            {
+                var name = _responseHeaders[i].Key;
+                var value = _responseHeaders[i].Value;
+                if (name.Equals("Set-Cookie", StringComparison.OrdinalIgnoreCase)) return;
+                if (name.Equals("Cache-Control", StringComparison.OrdinalIgnoreCase))
+                    cacheControl = cacheControl == null ? value : cacheControl + "," + value;
+                else if (name.Equals("Vary", StringComparison.OrdinalIgnoreCase))
+                    vary = vary == null ? value : vary + "," + value;
+                else if (name.Equals("Server", StringComparison.OrdinalIgnoreCase))
+                    hasServer = true;
+            }
+            var maxAge = ParseMaxAge(cacheControl);
+            if (maxAge <= 0) return;
+            var varyNames = ParseVary(vary);
+            if (varyNames == null) return;
+            var varyValues = new string[varyNames.Length];
+            for (var i = 0; i < varyNames.Length; i++)
+                varyValues[i] = GetRequestHeader(varyNames[i]);
+            var head = SerializeHead(status, body.Length, hasServer);
+            if (head == null) return;
+            var maxAgeMilliseconds = (int)Math.Min(int.MaxValue / 2, maxAge * 1000L);
+            _cache.Store(new ResponseCacheEntry(_key, varyNames, varyValues, head, body, Environment.TickCount, maxAgeMilliseconds));
+        }
+
+        // Returns 0 when response must not be cached, s-maxage is preferred because this is shared cache
+        static int ParseMaxAge(string cacheControl)
+        {
+            if (cacheControl == null) return 0;
+            var maxAge = 0;
+            var sharedMaxAge = -1;
+            foreach (var part in cacheControl.Split(','))
+            {
+                var directive = part.Trim();
+                if (directive.Equals("no-store", StringComparison.OrdinalIgnoreCase)
+                    || directive.Equals("no-cache", StringComparison.OrdinalIgnoreCase)
+                    || directive.StartsWith("private", StringComparison.OrdinalIgnoreCase))
+                    return 0;
+                int seconds;
+                if (directive.StartsWith("max-age=", StringComparison.OrdinalIgnoreCase))
+                {
+                    if (int.TryParse(directive.Substring(8), NumberStyles.None, CultureInfo.InvariantCulture, out seconds))
+                        maxAge = seconds;
+                }
+                else if (directive.StartsWith("s-maxage=", StringComparison.OrdinalIgnoreCase))
+                {
+                    if (int.TryParse(directive.Substring(9), NumberStyles.None, CultureInfo.InvariantCulture, out seconds))
+                        sharedMaxAge = seconds;
+                }
+            }
+            return sharedMaxAge >= 0 ? sharedMaxAge : maxAge;
+        }
+
+        // Returns null for Vary: * which cannot be matched
+        static string[] ParseVary(string vary)
+        {
+            if (vary == null) return new string[0];
+            var names = new List<string>();
+            foreach (var part in vary.Split(','))
+            {
+                var name = part.Trim();
+                if (name.Length == 0) continue;
+                if (name == "*") return null;
+                names.Add(name);
+            }
+            return names.ToArray();
+        }
+
+        // Returns null when some header could not be written as bytes without loss
+        byte[] SerializeHead(int status, int contentLength, bool hasServer)
+        {
+            var sb = new StringBuilder(256);
+            sb.Append("HTTP/1.1 ").Append(status.ToString(CultureInfo.InvariantCulture));
+            if (_reasonPhase != null)
+                sb.Append(' ').Append(_reasonPhase);
+            sb.Append("\r\nContent-Length: ").Append(contentLength.ToString(CultureInfo.InvariantCulture)).Append("\r\n");
+            if (_serverName != null && !hasServer)
+                sb.Append("Server: ").Append(_serverName).Append("\r\n");
+            for (var i = 0; i < _responseHeaders.Count; i++)
+            {
+                var name = _responseHeaders[i].Key;
+                // These are different for each connection or added when sending
+                if (name.Equals("Date", StringComparison.OrdinalIgnoreCase)
+                    || name.Equals("Age", StringComparison.OrdinalIgnoreCase)
+                    || name.Equals("Connection", StringComparison.OrdinalIgnoreCase)
+                    || name.Equals("Keep-Alive", StringComparison.OrdinalIgnoreCase)
+                    || name.Equals("Transfer-Encoding", StringComparison.OrdinalIgnoreCase)
+                    || name.Equals("Content-Length", StringComparison.OrdinalIgnoreCase))
+                    continue;
+                sb.Append(name).Append(": ").Append(_responseHeaders[i].Value).Append("\r\n");
+            }
+            var head = new byte[sb.Length];
+            for (var i = 0; i < head.Length; i++)
+            {
+                var ch = sb[i];
+                // Only Latin-1 survives byte per char, such response is sent by normal path each time
+                if (ch > 255) return null;
+                head[i] = (byte)ch;
+            }
+            return head;
+        }
+
+        public CancellationToken CallCancelled => _callback.CallCancelled;
+
+        public Stream ReqRespBody => _capturing ? _captureStream : _callback.ReqRespBody;
+
+        public string RequestPath => _callback.RequestPath;
+
+        public string RequestQueryString => _callback.RequestQueryString;
+
+        public string RequestMethod => _callback.RequestMethod;
+
+        public string RequestScheme => _callback.RequestScheme;
+
+        public string RequestProtocol => _callback.RequestProtocol;
+
+        public string RemoteIpAddress => _callback.RemoteIpAddress;
+
+        public string RemotePort => _callback.RemotePort;
+
+        public string LocalIpAddress => _callback.LocalIpAddress;
+
+        public string LocalPort => _callback.LocalPort;
+
+        public bool IsLocal => _callback.IsLocal;
+
+        public bool IsWebSocketReq => _callback.IsWebSocketReq;
+
+        public X509Certificate ClientCertificate => _callback.ClientCertificate;
+
+        public int ResponseStatusCode
+        {
+            get { return _callback.ResponseStatusCode; }
+            set { _callback.ResponseStatusCode = value; }
+        }
+
+        public string ResponseReasonPhase
+        {
+            set
+            {
+                _reasonPhase = value;
+                _callback.ResponseReasonPhase = value;
+            }
+        }
+
+        public ulong ResponseContentLength
+        {
+            set
+            {
+                _responseContentLength = value;
+                _callback.ResponseContentLength = value;
+            }
+        }
+
+        public bool KeepAlive
+        {
+            set { _callback.KeepAlive = value; }
+        }
+
+        public void AddResponseHeader(string name, string value)
+        {
+            if (_capturing)
+                _responseHeaders.Add(new KeyValuePair<string, string>(name, value));
+            _callback.AddResponseHeader(name, value);
+        }
+
+        public void AddResponseHeader(string name, IEnumerable<string> values)
+        {
+            if (_capturing)
+            {
+                foreach (var value in values)
+                    _responseHeaders.Add(new KeyValuePair<string, string>(name, value));
+            }
+            _callback.AddResponseHeader(name, values);
+        }
+
+        public void UpgradeToWebSocket()
+        {
+            AbandonCapture();
+            _callback.UpgradeToWebSocket();
+        }
+
+        public void ResponseFinished()
+        {
+            if (_capturing)
+            {
+                var status = _callback.ResponseStatusCode;
+                if (status == 599 || status == 5000 || _callback.CallCancelled.IsCancellationRequested)
+                {
+                    AbandonCapture();
+                }
+                else if (_responseHeadersCaptured)
+                {
+                    // Body was written already, after forwarding this handler could already serve next request
+                    StoreCaptured();
+                    EndFill();
+                }
+                else
+                {
+                    _finishing = true;
+                }
+            }
+            _callback.ResponseFinished();
+        }
+
+        public void CloseConnection()
+        {
+            AbandonCapture();
+            _callback.CloseConnection();
+        }
+
+        public bool HeadersSend => _callback.HeadersSend;
+
+        public byte[] Buffer => _callback.Buffer;
+
+        public int ReceiveDataOffset => _callback.ReceiveDataOffset;
+
+        public int ReceiveDataLength => _callback.ReceiveDataLength;
+
+        public void ConsumeReceiveData(int count)
+        {
+            _callback.ConsumeReceiveData(count);
+        }
+
+        public void StartReceiveData()
+        {
+            _callback.StartReceiveData();
+        }
+
+        public int SendDataOffset => _callback.SendDataOffset;
+
+        public int SendDataLength => _callback.SendDataLength;
+
+        public Task SendData(byte[] buffer, int offset, int length)
+        {
+            AbandonCapture();
+            return _callback.SendData(buffer, offset, length);
+        }
+
+        public Task SendFileAsync(string fileName, long offset, long? count, CancellationToken cancel)
+        {
+            AbandonCapture();
+            return _callback.SendFileAsync(fileName, offset, count, cancel);
+        }
+
+        public bool TrySendCachedResponse(byte[] head, int age, byte[] body)
+        {
+            return _callback.TrySendCachedResponse(head, age, body);
+        }
+    }
+}
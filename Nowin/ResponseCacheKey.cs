@@ -0,0 +1,44 @@
+using System;
+
+namespace Nowin
+{
+    // Variants of same key differing by Vary request headers are chained in ResponseCacheEntry.
+    // Host and scheme are part of key because application could serve different sites or redirect http to https.
+    struct ResponseCacheKey : IEquatable<ResponseCacheKey>
+    {
+        public readonly bool IsSsl;
+        public readonly string Host;
+        public readonly string Method;
+        public readonly string Path;
+        public readonly string QueryString;
+
+        public ResponseCacheKey(bool isSsl, string host, string method, string path, string queryString)
+        {
+            IsSsl = isSsl;
+            Host = host ?? "";
+            Method = method;
+            Path = path;
+            QueryString = queryString ?? "";
+        }
+
+        public bool Equals(ResponseCacheKey other)
+        {
+            return string.Equals(Path, other.Path, StringComparison.Ordinal)
+                && string.Equals(QueryString, other.QueryString, StringComparison.Ordinal)
+                && string.Equals(Host, other.Host, StringComparison.OrdinalIgnoreCase)
+                && IsSsl == other.IsSsl
+                && string.Equals(Method, other.Method, StringComparison.Ordinal);
+        }
+
+        public override bool Equals(object obj)
+        {
+            return obj is ResponseCacheKey && Equals((ResponseCacheKey)obj);
+        }
+
+        public override int GetHashCode()
+        {
+            return (((StringComparer.Ordinal.GetHashCode(Path) * 397) ^ StringComparer.Ordinal.GetHashCode(QueryString)) * 397)
+                ^ StringComparer.OrdinalIgnoreCase.GetHashCode(Host);
+        }
+    }
+}
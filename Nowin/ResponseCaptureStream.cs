@@ -0,0 +1,124 @@
+using System;
+using System.IO;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Nowin
+{
+    // Passes everything to connection stream and keeps copy of written response body for ResponseCacheHandler.
+    // Copy is abandoned when body grows over limit.
+    class ResponseCaptureStream : Stream
+    {
+        readonly Stream _inner;
+        readonly int _maxLength;
+        // Allocated on first write, so connections never filling cache do not pay for it
+        byte[] _captured;
+        int _length;
+        bool _overflow;
+
+        internal ResponseCaptureStream(Stream inner, int maxLength)
+        {
+            _inner = inner;
+            _maxLength = maxLength;
+        }
+
+        internal void Reset()
+        {
+            _length = 0;
+            _overflow = false;
+        }
+
+        // Response is not going to be stored, stop copying rest of it
+        internal void Abandon()
+        {
+            _overflow = true;
+        }
+
+        internal bool IsComplete => !_overflow;
+
+        internal byte[] ToArray()
+        {
+            var result = new byte[_length];
+            if (_length > 0) Array.Copy(_captured, result, _length);
+            return result;
+        }
+
+        void Capture(byte[] buffer, int offset, int count)
+        {
+            if (_overflow) return;
+            if (count > _maxLength - _length)
+            {
+                _overflow = true;
+                return;
+            }
+            var capacity = _captured?.Length ?? 0;
+            if (_length + count > capacity)
+            {
+                var newCaptured = new byte[Math.Min(_maxLength, Math.Max(Math.Max(capacity * 2, 4096), _length + count))];
+                if (_length > 0) Array.Copy(_captured, newCaptured, _length);
+                _captured = newCaptured;
+            }
+            Array.Copy(buffer, offset, _captured, _length, count);
+            _length += count;
+        }
+
+        public override void Write(byte[] buffer, int offset, int count)
+        {
+            Capture(buffer, offset, count);
+            _inner.Write(buffer, offset, count);
+        }
+
+        public override Task WriteAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken)
+        {
+            Capture(buffer, offset, count);
+            return _inner.WriteAsync(buffer, offset, count, cancellationToken);
+        }
+
+        public override int Read(byte[] buffer, int offset, int count)
+        {
+            return _inner.Read(buffer, offset, count);
+        }
+
+        public override Task<int> ReadAsync(byte[] buffer, int offset, int count, CancellationToken cancellationToken)
+        {
+            return _inner.ReadAsync(buffer, offset, count, cancellationToken);
+        }
+
+        public override void Flush()
+        {
+            _inner.Flush();
+        }
+
+        public override Task FlushAsync(CancellationToken cancellationToken)
+        {
+            return _inner.FlushAsync(cancellationToken);
+        }
+
+        public override long Seek(long offset, SeekOrigin origin)
+        {
+            throw new InvalidOperationException();
+        }
+
+        public override void SetLength(long value)
+        {
+            throw new InvalidOperationException();
+        }
+
+        public override bool CanRead => true;
+
+        public override bool CanSeek => false;
+
+        public override bool CanWrite => true;
+
+        public override long Length
+        {
+            get { throw new NotSupportedException(); }
+        }
+
+        public override long Position
+        {
+            get { throw new NotSupportedException(); }
+            set { throw new NotSupportedException(); }
+        }
+    }
+}
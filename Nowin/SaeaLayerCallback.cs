@@ -1,4 +1,5 @@
 using System;
+using System.Collections.Generic;
 using System.Diagnostics;
 using System.IO;
 using System.Net;
@@ -28,7 +29,9 @@ enum State
 
         readonly ITransportLayerHandler _handler;
         readonly Socket _listenSocket;
+        readonly ConnectionBlock _block;
         readonly Server _server;
+        readonly ServerMetrics _metrics;
         readonly int _handlerId;
         SocketAsyncEventArgs _acceptEvent;
         SocketAsyncEventArgs _receiveEvent;
@@ -44,12 +47,19 @@ public SaeaLayerCallback(ITransportLayerHandler handler, Socket listenSocket, Se
             _handler = handler;
             _listenSocket = listenSocket;
             _server = server;
+            _metrics = server.MetricsCollector;
             _handlerId = handlerId;
             _contextSuppresser = ExecutionContextFlowSuppresser.CreateContextSuppresser(contextFlow);
             RecreateSaeas();
             handler.Callback = this;
         }
 
+        internal SaeaLayerCallback(ITransportLayerHandler handler, ConnectionBlock block, Server server, int handlerId, ExecutionContextFlow contextFlow)
+            : this(handler, block.Shard.Socket, server, handlerId, contextFlow)
+        {
+            _block = block;
+        }
+
         void RecreateSaeas()
         {
             DisposeEventArgs();
@@ -88,6 +98,8 @@ static void IoCompleted(object sender, SocketAsyncEventArgs e)
                     Debug.Assert(e == self._acceptEvent);
                     if (e.SocketError != SocketError.Success)
                     {
+                        // Accept cancelled by retiring block gives its slot back, otherwise listen socket was closed
+                        if (self._block != null && self._block.IsRetiring) self.ProcessAccept();
                         return;
                     }
                     self.ProcessAccept();
@@ -97,6 +109,7 @@ static void IoCompleted(object sender, SocketAsyncEventArgs e)
                     self.ProcessReceive();
                     break;
                 case SocketAsyncOperation.Send:
+                case SocketAsyncOperation.SendPackets:
                     Debug.Assert(e == self._sendEvent);
                     self.ProcessSend();
                     break;
@@ -111,6 +124,7 @@ static void IoCompleted(object sender, SocketAsyncEventArgs e)
 
         void ProcessAccept()
         {
+            var startTimestamp = _metrics != null ? ServerMetrics.Timestamp() : 0;
             int oldState, newState;
             do
             {
@@ -129,13 +143,23 @@ void ProcessAccept()
                 {
                     remoteEndpoint = _socket.RemoteEndPoint as IPEndPoint;
                     localEndpoint = _socket.LocalEndPoint as IPEndPoint;
+                    // Responses are already gathered into few sends, Nagle would only delay last segment of each by delayed ACK of client
+                    _socket.NoDelay = true;
                 }
                 catch (SocketException) //"The socket is not connected" is intentionally ignored
                 { }
+                catch (ObjectDisposedException) // Closed by CancelAccept right after accept completed
+                { }
 
                 if (remoteEndpoint != null && localEndpoint != null)
                 {
-                    _server.ReportNewConnectedClient();
+                    _server.ReportNewConnectedClient(_block);
+                    if (_metrics != null)
+                    {
+                        _metrics.Increment(MetricsCounter.ConnectionsAccepted);
+                        _metrics.Add(MetricsCounter.BytesReceived, bytesTransfered);
+                        _metrics.RecordSince(MetricsStage.Accept, startTimestamp);
+                    }
                     _handler.FinishAccept(_acceptEvent.Buffer, _acceptEvent.Offset, bytesTransfered,
                         remoteEndpoint, localEndpoint);
                     return;
@@ -162,6 +186,7 @@ void ProcessReceive()
 
             if (bytesTransferred > 0 && _receiveEvent.SocketError == SocketError.Success)
             {
+                _metrics?.Add(MetricsCounter.BytesReceived, bytesTransferred);
                 _handler.FinishReceive(_receiveEvent.Buffer, _receiveEvent.Offset, bytesTransferred);
             }
             else
@@ -185,6 +210,10 @@ void ProcessSend()
             {
                 ex = new IOException();
             }
+            else
+            {
+                _metrics?.Add(MetricsCounter.BytesSent, _sendEvent.BytesTransferred);
+            }
             _handler.FinishSend(ex);
         }
 
@@ -205,7 +234,7 @@ void ProcessDisconnect()
                 _socket.Dispose();
             }
             _socket = null;
-            _server.ReportDisconnectedClient();
+            _server.ReportDisconnectedClient(_block);
             if (!delayedAccept)
                 _handler.PrepareAccept();
         }
@@ -213,6 +242,11 @@ void ProcessDisconnect()
         public void StartAccept(byte[] buffer, int offset, int length)
         {
             TraceSources.CoreDebug.TraceInformation("ID{0,-5} start accept {1} {2}", _handlerId, offset, length);
+            if (_block != null && _block.IsRetiring)
+            {
+                _block.ReleaseConnection(this);
+                return;
+            }
             int oldState, newState;
             do
             {
@@ -231,6 +265,17 @@ public void StartAccept(byte[] buffer, int offset, int length)
             }
             catch (ObjectDisposedException)
             {
+                // Reused accept socket closed by CancelAccept of block which started retiring meanwhile
+                if (_block != null && _block.IsRetiring && _acceptEvent.AcceptSocket != null)
+                {
+                    do
+                    {
+                        oldState = _state;
+                        newState = oldState & ~(int)State.Receive;
+                    } while (Interlocked.CompareExchange(ref _state, newState, oldState) != oldState);
+                    _acceptEvent.AcceptSocket = null;
+                    _block.ReleaseConnection(this);
+                }
                 return;
             }
             if (!willRaiseEvent)
@@ -241,6 +286,14 @@ public void StartAccept(byte[] buffer, int offset, int length)
             }
         }
 
+        // Windows AcceptEx waits on preallocated accept socket and closing it aborts the accept.
+        // Other runtimes create accepted socket only after accept completes, so there is nothing to close.
+        internal void CancelAccept()
+        {
+            if ((_state & (int)State.Receive) == 0 || _socket != null) return;
+            _acceptEvent.AcceptSocket?.Dispose();
+        }
+
         IDisposable StopExecutionContextFlow()
         {
             return _contextSuppresser();
@@ -284,22 +337,11 @@ public void StartReceive(byte[] buffer, int offset, int length)
         public void StartSend(byte[] buffer, int offset, int length)
         {
             TraceSources.CoreDebug.TraceInformation("ID{0,-5} start send {1} {2}", _handlerId, offset, length);
-            int oldState, newState;
-            do
-            {
-                oldState = _state;
-                if ((oldState & (int)State.Send) != 0)
-                    throw new InvalidOperationException("Already sending");
-                if ((oldState & (int)State.Aborting) != 0)
-                {
-                    _handler.FinishSend(new IOException());
-                    return;
-                }
-                newState = oldState | (int)State.Send;
-            } while (Interlocked.CompareExchange(ref _state, newState, oldState) != oldState);
+            if (!EnterSend()) return;
             bool willRaiseEvent;
             try
             {
+                if (_sendEvent.BufferList != null) _sendEvent.BufferList = null;
                 _sendEvent.SetBuffer(buffer, offset, length);
                 using (StopExecutionContextFlow())
                     willRaiseEvent = _socket.SendAsync(_sendEvent);
@@ -316,6 +358,80 @@ public void StartSend(byte[] buffer, int offset, int length)
             }
         }
 
+        public void StartSend(IList<ArraySegment<byte>> buffers)
+        {
+            TraceSources.CoreDebug.TraceInformation("ID{0,-5} start send {1} buffers", _handlerId, buffers.Count);
+            if (!EnterSend()) return;
+            bool willRaiseEvent;
+            try
+            {
+                // BufferList copies segments when send starts, so caller can reuse the list afterwards
+                _sendEvent.SetBuffer(null, 0, 0);
+                _sendEvent.BufferList = buffers;
+                using (StopExecutionContextFlow())
+                    willRaiseEvent = _socket.SendAsync(_sendEvent);
+            }
+            catch (ObjectDisposedException)
+            {
+                return;
+            }
+            if (!willRaiseEvent)
+            {
+                var e = _sendEvent;
+                TraceSources.CoreDebug.TraceInformation("ID{0,-5} Sync Send {1} {2} {3}", _handlerId, e.LastOperation, e.BytesTransferred, e.SocketError);
+                ProcessSend();
+            }
+        }
+
+        public void StartSendFile(IList<ArraySegment<byte>> head, string fileName, long offset, long count, ArraySegment<byte> tail)
+        {
+            TraceSources.CoreDebug.TraceInformation("ID{0,-5} start send file {1} {2} {3}", _handlerId, fileName, offset, count);
+            if (!EnterSend()) return;
+            bool willRaiseEvent;
+            try
+            {
+                var elements = new SendPacketsElement[head.Count + (tail.Array != null ? 2 : 1)];
+                for (var i = 0; i < head.Count; i++)
+                {
+                    elements[i] = new SendPacketsElement(head[i].Array, head[i].Offset, head[i].Count);
+                }
+                elements[head.Count] = new SendPacketsElement(fileName, (int)offset, (int)count);
+                if (tail.Array != null)
+                    elements[head.Count + 1] = new SendPacketsElement(tail.Array, tail.Offset, tail.Count);
+                _sendEvent.SendPacketsElements = elements;
+                using (StopExecutionContextFlow())
+                    willRaiseEvent = _socket.SendPacketsAsync(_sendEvent);
+            }
+            catch (ObjectDisposedException)
+            {
+                return;
+            }
+            if (!willRaiseEvent)
+            {
+                var e = _sendEvent;
+                TraceSources.CoreDebug.TraceInformation("ID{0,-5} Sync Send File {1} {2} {3}", _handlerId, e.LastOperation, e.BytesTransferred, e.SocketError);
+                ProcessSend();
+            }
+        }
+
+        bool EnterSend()
+        {
+            int oldState, newState;
+            do
+            {
+                oldState = _state;
+                if ((oldState & (int)State.Send) != 0)
+                    throw new InvalidOperationException("Already sending");
+                if ((oldState & (int)State.Aborting) != 0)
+                {
+                    _handler.FinishSend(new IOException());
+                    return false;
+                }
+                newState = oldState | (int)State.Send;
+            } while (Interlocked.CompareExchange(ref _state, newState, oldState) != oldState);
+            return true;
+        }
+
         public void StartDisconnect()
         {
             TraceSources.CoreDebug.TraceInformation("ID{0,-5} start disconnect", _handlerId);
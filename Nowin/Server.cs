@@ -1,5 +1,5 @@
 using System;
-using System.Collections.Concurrent;
+using System.Collections.Generic;
 using System.Net.Sockets;
 using System.Text;
 using System.Threading;
@@ -7,86 +7,263 @@
 
 namespace Nowin
 {
-    public class Server : INowinServer
+    public class Server : INowinServer, INowinServerMetrics
     {
         internal static readonly byte[] Status100Continue = Encoding.UTF8.GetBytes("HTTP/1.1 100 Continue\r\n\r\n");
+        const int MaxRetainedBlockBuffers = 2;
 
         readonly IServerParameters _parameters;
 
-        readonly ConcurrentBag<ConnectionBlock> _blocks = new ConcurrentBag<ConnectionBlock>();
-        internal Socket ListenSocket;
+        // Guarded by _newConnectionLock
+        readonly List<ConnectionBlock> _blocks = new List<ConnectionBlock>();
+        readonly ConnectionBufferPool _bufferPool = new ConnectionBufferPool(MaxRetainedBlockBuffers);
+        ListenerShard[] _shards;
         internal int AllocatedConnections;
         internal int ConnectedCount;
+        internal int RetiredConnections;
         readonly object _newConnectionLock = new object();
+        Timer _releaseTimer;
         ILayerFactory _layerFactory;
         IConnectionAllocationStrategy _connectionAllocationStrategy;
         IIpIsLocalChecker _ipIsLocalChecker;
+        internal ServerMetrics MetricsCollector;
 
         internal Server(IServerParameters parameters)
         {
             _parameters = parameters;
         }
 
-        internal void ReportNewConnectedClient()
+        internal void ReportNewConnectedClient(ConnectionBlock block)
         {
+            ListenerShard shard = null;
+            if (block != null)
+            {
+                block.ReportConnected();
+                shard = block.Shard;
+                Interlocked.Increment(ref shard.ConnectedCount);
+            }
             var cc = Interlocked.Increment(ref ConnectedCount);
-            var add = _connectionAllocationStrategy.CalculateNewConnectionCount(AllocatedConnections, cc);
+            var add = shard != null
+                ? ShardNewConnectionCount(shard)
+                : _connectionAllocationStrategy.CalculateNewConnectionCount(AllocatedConnections, cc);
             if (add <= 0) return;
             Task.Run(() =>
                 {
                     lock (_newConnectionLock)
                     {
-                        var delta = _connectionAllocationStrategy.CalculateNewConnectionCount(AllocatedConnections, ConnectedCount);
-                        if (delta <= 0) return;
-                        AllocatedConnections += delta;
-                        _blocks.Add(new ConnectionBlock(this, _layerFactory, delta));
+                        if (shard == null)
+                        {
+                            var delta = _connectionAllocationStrategy.CalculateNewConnectionCount(AllocatedConnections, ConnectedCount);
+                            if (delta <= 0) return;
+                            AllocatedConnections += delta;
+                            AddConnectionBlock(MostLoadedShard(), delta);
+                            return;
+                        }
+                        var shardDelta = ShardNewConnectionCount(shard);
+                        if (shardDelta <= 0) return;
+                        AllocatedConnections += shardDelta;
+                        AddConnectionBlock(shard, shardDelta);
                     }
                 });
         }
 
-        internal void ReportDisconnectedClient()
+        // Kernel picks listen socket of new connection, so only accepts waiting on that shard could take it.
+        // Strategy judges shard as if whole server looked like it, growth step is split between shards the same way.
+        int ShardNewConnectionCount(ListenerShard shard)
+        {
+            var shardCount = _shards.Length;
+            if (shardCount == 1) return _connectionAllocationStrategy.CalculateNewConnectionCount(AllocatedConnections, ConnectedCount);
+            return ShardNewConnectionCount(_connectionAllocationStrategy, shardCount, AllocatedConnections, shard.AllocatedConnections, Volatile.Read(ref shard.ConnectedCount));
+        }
+
+        internal static int ShardNewConnectionCount(IConnectionAllocationStrategy strategy, int shardCount, int allocated, int shardAllocated, int shardConnected)
         {
+            var delta = strategy.CalculateNewConnectionCount(shardAllocated * shardCount, shardConnected * shardCount);
+            if (delta <= 0) return 0;
+            delta = (delta + shardCount - 1) / shardCount;
+            // Projection of smaller shard does not see bigger ones, so server as whole must be still allowed to grow
+            if (strategy.CalculateNewConnectionCount(allocated, allocated - (shardAllocated - shardConnected)) <= 0) return 0;
+            var max = (strategy as ConnectionAllocationStrategy)?.MaxCount ?? int.MaxValue;
+            return Math.Max(Math.Min(delta, max - allocated), 0);
+        }
+
+        // Same view of shard as in ShardNewConnectionCount, so released shard does not grow again right away
+        int ShardReleasableConnectionCount(IElasticConnectionAllocationStrategy strategy, ListenerShard shard)
+        {
+            var shardCount = _shards.Length;
+            if (shardCount == 1) return strategy.CalculateReleasableConnectionCount(AllocatedConnections, ConnectedCount);
+            var releasable = strategy.CalculateReleasableConnectionCount(shard.AllocatedConnections * shardCount, Volatile.Read(ref shard.ConnectedCount) * shardCount);
+            return releasable <= 0 ? 0 : releasable / shardCount;
+        }
+
+        internal void ReportDisconnectedClient(ConnectionBlock block)
+        {
+            if (block != null)
+            {
+                block.ReportDisconnected();
+                Interlocked.Decrement(ref block.Shard.ConnectedCount);
+            }
             Interlocked.Decrement(ref ConnectedCount);
         }
 
+        // Slot is counted as allocated until released, because till then it still accepts and serves connections
+        internal void ReportReleasedConnection(ConnectionBlock block)
+        {
+            lock (_newConnectionLock)
+            {
+                AllocatedConnections--;
+                block.Shard.AllocatedConnections--;
+            }
+            Interlocked.Decrement(ref RetiredConnections);
+        }
+
+        internal void ReportReleasedBlock(ConnectionBlock block)
+        {
+            lock (_newConnectionLock)
+            {
+                if (!_blocks.Remove(block)) return;
+            }
+            _bufferPool.Return(block.Buffer);
+        }
+
+        void ReleaseIdleBlock(object state)
+        {
+            ConnectionBlock retiring = null;
+            lock (_newConnectionLock)
+            {
+                var strategy = _connectionAllocationStrategy as IElasticConnectionAllocationStrategy;
+                if (strategy == null) return;
+                // Only one block retires at a time, released counts are not known before its slots are released
+                retiring = _blocks.Find(b => b.IsRetiring);
+                if (retiring == null)
+                {
+                    // Newest blocks first, at most one block per check
+                    for (var i = _blocks.Count - 1; i >= 0; i--)
+                    {
+                        var block = _blocks[i];
+                        if (block.ConnectionCount > ShardReleasableConnectionCount(strategy, block.Shard)) continue;
+                        // Shard must keep some waiting accepts
+                        if (block.Shard.AllocatedConnections == block.ConnectionCount) continue;
+                        if (!block.IsIdleFor(strategy.IdleWindow)) continue;
+                        Interlocked.Add(ref RetiredConnections, block.ConnectionCount);
+                        block.Retire();
+                        retiring = block;
+                        break;
+                    }
+                }
+            }
+            retiring?.CancelWaitingAccepts();
+        }
+
+        ListenerShard MostLoadedShard()
+        {
+            var result = _shards[0];
+            for (var i = 1; i < _shards.Length; i++)
+            {
+                if (_shards[i].FreeConnections < result.FreeConnections) result = _shards[i];
+            }
+            return result;
+        }
+
+        void AddConnectionBlock(ListenerShard shard, int connectionCount)
+        {
+            shard.AllocatedConnections += connectionCount;
+            _blocks.Add(new ConnectionBlock(this, shard, _layerFactory, _bufferPool, connectionCount));
+        }
+
         public void Start()
         {
-            _layerFactory = new OwinHandlerFactory(_parameters.OwinApp, _parameters.OwinCapabilities);
+            var app = _parameters.OwinApp;
+            if (_parameters.MetricsEnabled)
+            {
+                MetricsCollector = new ServerMetrics(_parameters.MetricsLatencySampleInterval);
+                if (_parameters.MetricsEndpointPath != null)
+                    app = new MetricsEndpoint(app, MetricsCollector, _parameters.MetricsEndpointPath).Invoke;
+            }
+            _layerFactory = new OwinHandlerFactory(app, _parameters.OwinCapabilities);
+            if (_parameters.ResponseCacheSize > 0)
+            {
+                _layerFactory = new ResponseCacheFactory(_layerFactory, _parameters.ResponseCacheSize, _parameters.ResponseCacheMaxEntrySize, _parameters.ServerHeader, MetricsCollector, _parameters.ResponseCacheRequestsWithCookies);
+            }
             _ipIsLocalChecker = new IpIsLocalChecker();
             _connectionAllocationStrategy = _parameters.ConnectionAllocationStrategy;
             var isSsl = _parameters.Certificate != null;
-            _layerFactory = new Transport2HttpFactory(_parameters.BufferSize, isSsl, _parameters.ServerHeader, _ipIsLocalChecker, _layerFactory);
+            _layerFactory = new Transport2HttpFactory(_parameters.BufferSize, isSsl, _parameters.ServerHeader, _ipIsLocalChecker, _layerFactory, MetricsCollector, _parameters.ConnectionTimeouts);
             if (isSsl)
             {
-                _layerFactory = new SslTransportFactory(_parameters, _layerFactory);
+                _layerFactory = new SslTransportFactory(_parameters, _layerFactory, MetricsCollector);
             }
 
-            ListenSocket = new Socket(AddressFamily.InterNetworkV6, SocketType.Stream, ProtocolType.Tcp);
-            ListenSocket.SetSocketOption(SocketOptionLevel.IPv6, SocketOptionName.IPv6Only, false);
-
+            var shardCount = _parameters.ListenerShards;
+            if (shardCount > 1 && !ListenerShard.IsReusePortSupported)
+            {
+                TraceSources.Core.TraceWarning("SO_REUSEPORT is not supported on this platform, using single listen socket instead of {0}", shardCount);
+                shardCount = 1;
+            }
+            var initialConnectionCount = _connectionAllocationStrategy.CalculateNewConnectionCount(0, 0);
+            if (shardCount > initialConnectionCount && shardCount > 1)
+            {
+                // Every shard needs at least one waiting accept and strategy allows only initialConnectionCount of them
+                TraceSources.Core.TraceWarning("Initial connection count {0} is lower than {1} listener shards, using {2} shards", initialConnectionCount, shardCount, Math.Max(initialConnectionCount, 1));
+                shardCount = Math.Max(initialConnectionCount, 1);
+            }
+            _shards = new ListenerShard[shardCount];
             var start = DateTime.UtcNow;
-            while (true)
+            try
             {
-                try
+                for (var i = 0; i < shardCount; i++)
                 {
-                    ListenSocket.Bind(_parameters.EndPoint);
-                    break;
+                    var listenSocket = ListenerShard.CreateSocket(shardCount > 1);
+                    _shards[i] = new ListenerShard(listenSocket, i);
+                    while (true)
+                    {
+                        try
+                        {
+                            listenSocket.Bind(_parameters.EndPoint);
+                            break;
+                        }
+                        catch when(start + _parameters.RetrySocketBindingTime > DateTime.UtcNow)
+                        {
+                        }
+                        Thread.Sleep(50);
+                    }
+                    listenSocket.Listen(_parameters.ListenBacklog);
                 }
-                catch when(start + _parameters.RetrySocketBindingTime > DateTime.UtcNow)
+            }
+            catch
+            {
+                foreach (var shard in _shards)
                 {
+                    shard?.Socket.Dispose();
                 }
-                Thread.Sleep(50);
+                _shards = null;
+                throw;
+            }
+            AllocatedConnections = Math.Max(initialConnectionCount, shardCount);
+            lock (_newConnectionLock)
+            {
+                for (var i = 0; i < shardCount; i++)
+                {
+                    var count = AllocatedConnections / shardCount + (i < AllocatedConnections % shardCount ? 1 : 0);
+                    AddConnectionBlock(_shards[i], count);
+                }
+            }
+            var elasticStrategy = _connectionAllocationStrategy as IElasticConnectionAllocationStrategy;
+            if (elasticStrategy != null)
+            {
+                var period = TimeSpan.FromTicks(Math.Max(elasticStrategy.IdleWindow.Ticks / 4, TimeSpan.TicksPerMillisecond * 100));
+                _releaseTimer = new Timer(ReleaseIdleBlock, null, period, period);
             }
-            ListenSocket.Listen(100);
-            var initialConnectionCount = _connectionAllocationStrategy.CalculateNewConnectionCount(0, 0);
-            AllocatedConnections = initialConnectionCount;
-            _blocks.Add(new ConnectionBlock(this, _layerFactory, initialConnectionCount));
         }
 
         public int ConnectionCount => ConnectedCount;
 
         public int CurrentMaxConnectionCount => AllocatedConnections;
 
+        public int RetiredConnectionCount => RetiredConnections;
+
+        public ServerMetrics Metrics => MetricsCollector;
+
         public ExecutionContextFlow ContextFlow => _parameters.ContextFlow;
 
         public void Dispose()
@@ -95,11 +272,23 @@ public void Dispose()
             {
                 _connectionAllocationStrategy = new FinishingAllocationStrategy();
             }
+            _releaseTimer?.Dispose();
 
-            ListenSocket?.Dispose();
+            if (_shards != null)
+            {
+                foreach (var shard in _shards)
+                {
+                    shard?.Socket.Dispose();
+                }
+            }
 
-            ConnectionBlock block;
-            while (_blocks.TryTake(out block))
+            ConnectionBlock[] blocks;
+            lock (_newConnectionLock)
+            {
+                blocks = _blocks.ToArray();
+                _blocks.Clear();
+            }
+            foreach (var block in blocks)
             {
                 block.Stop();
             }
@@ -20,6 +20,19 @@ public class ServerBuilder : IServerParameters, IUpdateCertificate
         ExecutionContextFlow _contextFlow = ExecutionContextFlow.SuppressAlways;
         TimeSpan _retrySocketBindingTime;
         bool _clientCertificateRequired;
+        int _listenBacklog = 100;
+        int _listenerShards = 1;
+        bool _metricsEnabled;
+        string _metricsEndpointPath;
+        int _metricsLatencySampleInterval = ServerMetrics.DefaultLatencySampleInterval;
+        // Timeouts are off by default as in older versions, grace period applies only after rate is set
+        TimeSpan _keepAliveTimeout;
+        TimeSpan _requestHeadTimeout;
+        int _minRequestBodyDataRate;
+        TimeSpan _requestBodyGracePeriod = TimeSpan.FromSeconds(5);
+        long _responseCacheSize;
+        int _responseCacheMaxEntrySize;
+        bool _responseCacheRequestsWithCookies;
 
         public static ServerBuilder New()
         {
@@ -106,6 +119,84 @@ public ServerBuilder SetExecutionContextFlow(ExecutionContextFlow flow)
             return this;
         }
 
+        public ServerBuilder SetListenBacklog(int backlog)
+        {
+            if (backlog < 1) throw new ArgumentOutOfRangeException(nameof(backlog), backlog, "Must be positive");
+            _listenBacklog = backlog;
+            return this;
+        }
+
+        // Number of listen sockets bound with SO_REUSEPORT each with its own connection blocks, 0 means one per processor.
+        // Platforms without SO_REUSEPORT (Windows) always use single listen socket.
+        // SO_REUSEPORT also lets other process of same user bind the port and silently take part of connections, RetrySocketBindingTime will not report it.
+        public ServerBuilder SetListenerShards(int count)
+        {
+            if (count < 0) throw new ArgumentOutOfRangeException(nameof(count), count, "Must be non negative");
+            _listenerShards = count;
+            return this;
+        }
+
+        public ServerBuilder EnableMetrics()
+        {
+            _metricsEnabled = true;
+            return this;
+        }
+
+        // Stage latencies of every n-th request on connection are measured, 1 measures all of them but costs noticeably more
+        public ServerBuilder SetMetricsLatencySampleInterval(int interval)
+        {
+            if (interval < 1) throw new ArgumentOutOfRangeException(nameof(interval), interval, "Must be positive");
+            _metricsLatencySampleInterval = interval;
+            return this;
+        }
+
+        // Enables metrics and serves them in Prometheus text format on given path (for example "/metrics") before calling OWIN app
+        public ServerBuilder SetMetricsEndpoint(string path)
+        {
+            if (string.IsNullOrEmpty(path) || path[0] != '/') throw new ArgumentException("Must start with /", nameof(path));
+            _metricsEnabled = true;
+            _metricsEndpointPath = path;
+            return this;
+        }
+
+        // Idle keep-alive connection is closed after this time, TimeSpan.Zero disables it
+        public ServerBuilder SetKeepAliveTimeout(TimeSpan timeout)
+        {
+            if (timeout < TimeSpan.Zero) throw new ArgumentOutOfRangeException(nameof(timeout), timeout, "Must be non negative");
+            _keepAliveTimeout = timeout;
+            return this;
+        }
+
+        // Whole request head must be received in this time, TimeSpan.Zero disables it
+        public ServerBuilder SetRequestHeadTimeout(TimeSpan timeout)
+        {
+            if (timeout < TimeSpan.Zero) throw new ArgumentOutOfRangeException(nameof(timeout), timeout, "Must be non negative");
+            _requestHeadTimeout = timeout;
+            return this;
+        }
+
+        // Client slower than bytesPerSecond after gracePeriod is disconnected while application reads request body, 0 disables it
+        public ServerBuilder SetMinRequestBodyDataRate(int bytesPerSecond, TimeSpan gracePeriod)
+        {
+            if (bytesPerSecond < 0) throw new ArgumentOutOfRangeException(nameof(bytesPerSecond), bytesPerSecond, "Must be non negative");
+            if (gracePeriod < TimeSpan.Zero) throw new ArgumentOutOfRangeException(nameof(gracePeriod), gracePeriod, "Must be non negative");
+            _minRequestBodyDataRate = bytesPerSecond;
+            _requestBodyGracePeriod = gracePeriod;
+            return this;
+        }
+
+        // GET responses with Cache-Control max-age are kept in memory up to maxSize bytes and served without calling application.
+        // Requests with Cookie are passed to application unless cacheRequestsWithCookies is set.
+        public ServerBuilder EnableResponseCache(long maxSize, int maxEntrySize, bool cacheRequestsWithCookies = false)
+        {
+            if (maxSize <= 0) throw new ArgumentOutOfRangeException(nameof(maxSize), maxSize, "Must be positive");
+            if (maxEntrySize <= 0 || maxEntrySize > maxSize) throw new ArgumentOutOfRangeException(nameof(maxEntrySize), maxEntrySize, "Must be positive and not bigger than maxSize");
+            _responseCacheSize = maxSize;
+            _responseCacheMaxEntrySize = maxEntrySize;
+            _responseCacheRequestsWithCookies = cacheRequestsWithCookies;
+            return this;
+        }
+
         public ServerBuilder SetServerHeader(string value)
         {
             _serverHeader = string.IsNullOrWhiteSpace(value) ? null : value;
@@ -162,6 +253,25 @@ int IServerParameters.BufferSize
 
         public bool ClientCertificateRequired => _clientCertificateRequired;
 
+        int IServerParameters.ListenBacklog => _listenBacklog;
+
+        int IServerParameters.ListenerShards => _listenerShards == 0 ? Environment.ProcessorCount : _listenerShards;
+
+        bool IServerParameters.MetricsEnabled => _metricsEnabled;
+
+        string IServerParameters.MetricsEndpointPath => _metricsEndpointPath;
+
+        int IServerParameters.MetricsLatencySampleInterval => _metricsLatencySampleInterval;
+
+        ConnectionTimeouts IServerParameters.ConnectionTimeouts
+            => new ConnectionTimeouts(_keepAliveTimeout, _requestHeadTimeout, _minRequestBodyDataRate, _requestBodyGracePeriod);
+
+        long IServerParameters.ResponseCacheSize => _responseCacheSize;
+
+        int IServerParameters.ResponseCacheMaxEntrySize => _responseCacheMaxEntrySize;
+
+        bool IServerParameters.ResponseCacheRequestsWithCookies => _responseCacheRequestsWithCookies;
+
         public void UpdateCertificate(X509Certificate certificate)
         {
             _certificate = certificate;
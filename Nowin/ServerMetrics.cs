@@ -0,0 +1,178 @@
+using System;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Threading;
+
+namespace Nowin
+{
+    // Lock-free counters and latency histograms. Writers are striped by thread so hot path is single uncontended interlocked add,
+    // readers sum all stripes. Counters count every request, per request stage latencies only every n-th request of each connection,
+    // because reading clock four times per request would cost more than all counters together.
+    public class ServerMetrics
+    {
+        public const int DefaultLatencySampleInterval = 16;
+
+        static readonly int CounterCount = Enum.GetValues(typeof(MetricsCounter)).Length;
+        static readonly int StageCount = Enum.GetValues(typeof(MetricsStage)).Length;
+        // Stripe of counters fills whole cache lines so neighbouring stripes never share one
+        static readonly int CounterStripeLength = (CounterCount + 7) / 8 * 8 + 8;
+
+        static readonly string[] CounterNames =
+        {
+            "nowin_connections_accepted_total",
+            "nowin_requests_total",
+            "nowin_received_bytes_total",
+            "nowin_sent_bytes_total",
+            "nowin_responses_1xx_total",
+            "nowin_responses_2xx_total",
+            "nowin_responses_3xx_total",
+            "nowin_responses_4xx_total",
+            "nowin_responses_5xx_total",
+            "nowin_connection_aborts_total",
+            "nowin_tls_handshake_failures_total",
+            "nowin_connection_timeouts_total",
+            "nowin_response_cache_hits_total",
+            "nowin_response_cache_misses_total"
+        };
+
+        static readonly string[] StageNames =
+        {
+            "accept",
+            "request_head",
+            "parse",
+            "app",
+            "send",
+            "keep_alive_idle",
+            "tls_handshake"
+        };
+
+        static readonly double[] ReportedPercentiles = { 50, 90, 99, 99.9 };
+        static readonly double MicrosecondsPerTimestamp = 1000000.0 / Stopwatch.Frequency;
+
+        readonly int _stripeMask;
+        readonly int _latencySampleInterval;
+        readonly long[][] _counters;
+        readonly LatencyHistogram[] _stages;
+
+        public ServerMetrics() : this(DefaultLatencySampleInterval)
+        {
+        }
+
+        // 1 measures stage latencies of every request
+        public ServerMetrics(int latencySampleInterval)
+        {
+            if (latencySampleInterval < 1) throw new ArgumentOutOfRangeException(nameof(latencySampleInterval), latencySampleInterval, "Must be positive");
+            _latencySampleInterval = latencySampleInterval;
+            var stripes = 1;
+            // More stripes than cores only spread same number of writers over more memory
+            while (stripes < Environment.ProcessorCount && stripes < 16) stripes *= 2;
+            _stripeMask = stripes - 1;
+            _counters = new long[stripes][];
+            for (var i = 0; i < stripes; i++)
+            {
+                _counters[i] = new long[CounterStripeLength];
+            }
+            _stages = new LatencyHistogram[StageCount];
+            for (var i = 0; i < StageCount; i++)
+            {
+                _stages[i] = new LatencyHistogram(stripes);
+            }
+        }
+
+        int Stripe => Thread.CurrentThread.ManagedThreadId & _stripeMask;
+
+        internal static long Timestamp()
+        {
+            return Stopwatch.GetTimestamp();
+        }
+
+        // Countdown is owned by connection, so deciding does not touch any shared memory
+        internal bool SampleLatency(ref int countdown)
+        {
+            if (--countdown > 0) return false;
+            countdown = _latencySampleInterval;
+            return true;
+        }
+
+        internal void Increment(MetricsCounter counter)
+        {
+            Interlocked.Increment(ref _counters[Stripe][(int)counter]);
+        }
+
+        internal void Add(MetricsCounter counter, long value)
+        {
+            Interlocked.Add(ref _counters[Stripe][(int)counter], value);
+        }
+
+        internal void RecordStatusCode(int statusCode)
+        {
+            var statusClass = statusCode / 100;
+            if (statusClass < 1 || statusClass > 5) statusClass = 5;
+            Increment(MetricsCounter.Status1xx + (statusClass - 1));
+        }
+
+        // Returns current timestamp so it can be used as start of next stage without reading clock again
+        internal long RecordSince(MetricsStage stage, long startTimestamp)
+        {
+            var now = Stopwatch.GetTimestamp();
+            _stages[(int)stage].Record(Stripe, (long)((now - startTimestamp) * MicrosecondsPerTimestamp));
+            return now;
+        }
+
+        public long GetCounter(MetricsCounter counter)
+        {
+            long result = 0;
+            foreach (var stripe in _counters)
+            {
+                result += Volatile.Read(ref stripe[(int)counter]);
+            }
+            return result;
+        }
+
+        public LatencySnapshot GetLatency(MetricsStage stage)
+        {
+            return _stages[(int)stage].Snapshot();
+        }
+
+        // Prometheus text exposition format, latencies are reported as summaries in seconds, their counts are counts of sampled requests
+        public void WriteText(TextWriter writer)
+        {
+            for (var i = 0; i < CounterCount; i++)
+            {
+                writer.Write("# TYPE ");
+                writer.Write(CounterNames[i]);
+                writer.Write(" counter\n");
+                writer.Write(CounterNames[i]);
+                writer.Write(' ');
+                writer.Write(GetCounter((MetricsCounter)i).ToString(CultureInfo.InvariantCulture));
+                writer.Write('\n');
+            }
+            writer.Write("# TYPE nowin_stage_duration_seconds summary\n");
+            for (var i = 0; i < StageCount; i++)
+            {
+                var snapshot = GetLatency((MetricsStage)i);
+                foreach (var percentile in ReportedPercentiles)
+                {
+                    writer.Write("nowin_stage_duration_seconds{stage=\"");
+                    writer.Write(StageNames[i]);
+                    writer.Write("\",quantile=\"");
+                    writer.Write((percentile / 100).ToString(CultureInfo.InvariantCulture));
+                    writer.Write("\"} ");
+                    writer.Write(snapshot.GetPercentile(percentile).TotalSeconds.ToString("R", CultureInfo.InvariantCulture));
+                    writer.Write('\n');
+                }
+                writer.Write("nowin_stage_duration_seconds_sum{stage=\"");
+                writer.Write(StageNames[i]);
+                writer.Write("\"} ");
+                writer.Write(snapshot.Sum.TotalSeconds.ToString("R", CultureInfo.InvariantCulture));
+                writer.Write('\n');
+                writer.Write("nowin_stage_duration_seconds_count{stage=\"");
+                writer.Write(StageNames[i]);
+                writer.Write("\"} ");
+                writer.Write(snapshot.Count.ToString(CultureInfo.InvariantCulture));
+                writer.Write('\n');
+            }
+        }
+    }
+}
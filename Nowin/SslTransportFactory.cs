@@ -4,11 +4,13 @@ public class SslTransportFactory : ILayerFactory
     {
         readonly IServerParameters _serverParameters;
         readonly ILayerFactory _next;
+        readonly ServerMetrics _metrics;
 
-        internal SslTransportFactory(IServerParameters serverParameters, ILayerFactory next)
+        internal SslTransportFactory(IServerParameters serverParameters, ILayerFactory next, ServerMetrics metrics)
         {
             _serverParameters = serverParameters;
             _next = next;
+            _metrics = metrics;
         }
 
         public int PerConnectionBufferSize => _next.PerConnectionBufferSize;
@@ -23,7 +25,7 @@ public void InitCommonBuffer(byte[] buffer, int offset)
         public ILayerHandler Create(byte[] buffer, int offset, int commonOffset, int handlerId)
         {
             var nextHandler = (ITransportLayerHandler)_next.Create(buffer, offset, commonOffset, handlerId);
-            var handler = new SslTransportHandler(nextHandler, _serverParameters);
+            var handler = new SslTransportHandler(nextHandler, _serverParameters, _metrics);
             return handler;
         }
     }
@@ -1,4 +1,5 @@
 using System;
+using System.Collections.Generic;
 using System.Diagnostics;
 using System.IO;
 using System.Net;
@@ -14,17 +15,22 @@ class SslTransportHandler : ITransportLayerHandler, ITransportLayerCallback
     {
         readonly ITransportLayerHandler _next;
         readonly IServerParameters _serverParameters;
+        readonly ServerMetrics _metrics;
         SslStream _ssl;
         Task _authenticateTask;
+        long _handshakeStartTimestamp;
         byte[] _recvBuffer;
         int _recvOffset;
         int _recvLength;
+        // Allocated on first file send and kept by connection slot, bigger one would not help as TLS record has at most 16kb
+        byte[] _fileBuffer;
         readonly InputStream _inputStream;
 
-        public SslTransportHandler(ITransportLayerHandler next, IServerParameters serverParameters)
+        public SslTransportHandler(ITransportLayerHandler next, IServerParameters serverParameters, ServerMetrics metrics)
         {
             _next = next;
             _serverParameters = serverParameters;
+            _metrics = metrics;
             _inputStream = new InputStream(this);
             next.Callback = this;
         }
@@ -80,6 +86,13 @@ Task<int> ReadOverflowAsync(byte[] buffer, int offset, int count, AsyncCallback
             {
                 _tcsReceive = new TaskCompletionSource<int>(state);
                 _callbackReceive = callback;
+                if (count == 0)
+                {
+                    // Stream contract allows zero byte read to complete at once, socket would report it as closed connection
+                    _tcsReceive.SetResult(0);
+                    callback?.Invoke(_tcsReceive.Task);
+                    return _tcsReceive.Task;
+                }
                 _owner.Callback.StartReceive(buffer, offset, count);
                 return _tcsReceive.Task;
             }
@@ -191,9 +204,11 @@ public void FinishAccept(byte[] buffer, int offset, int length, IPEndPoint remot
             try
             {
                 _ssl = new SslStream(_inputStream, true);
+                if (_metrics != null) _handshakeStartTimestamp = ServerMetrics.Timestamp();
                 _authenticateTask = _ssl.AuthenticateAsServerAsync(_serverParameters.Certificate, _serverParameters.ClientCertificateRequired, _serverParameters.Protocols, false).ContinueWith((t, selfObject) =>
                   {
                       var self = (SslTransportHandler)selfObject;
+                      self._metrics?.RecordSince(MetricsStage.TlsHandshake, self._handshakeStartTimestamp);
                       self._next.SetRemoteCertificate(_ssl.RemoteCertificate);
                   }, this, TaskContinuationOptions.OnlyOnRanToCompletion);
                 _next.FinishAccept(_recvBuffer, _recvOffset, 0, remoteEndPoint, localEndPoint);
@@ -241,6 +256,7 @@ public void StartReceive(byte[] buffer, int offset, int length)
                         var self = (SslTransportHandler)selfObject;
                         if (t.IsCanceled || t.IsFaulted)
                         {
+                            self._metrics?.Increment(MetricsCounter.TlsHandshakeFailures);
                             self._next.FinishReceive(null, 0, -1);
                         }
                         else
@@ -267,6 +283,7 @@ public void StartReceive(byte[] buffer, int offset, int length)
 
                 if (_authenticateTask.IsCanceled || _authenticateTask.IsFaulted)
                 {
+                    _metrics?.Increment(MetricsCounter.TlsHandshakeFailures);
                     _next.FinishReceive(null, 0, -1);
                     return;
                 }
@@ -290,29 +307,82 @@ public void StartSend(byte[] buffer, int offset, int length)
         {
             try
             {
-                _ssl.WriteAsync(buffer, offset, length).ContinueWith((t, selfObject) =>
+                ContinueWithFinishSend(_ssl.WriteAsync(buffer, offset, length));
+            }
+            catch (Exception ex)
+            {
+                _next.FinishSend(ex);
+            }
+        }
+
+        public void StartSend(IList<ArraySegment<byte>> buffers)
+        {
+            StartSendFile(buffers, null, 0, 0, default(ArraySegment<byte>));
+        }
+
+        public void StartSendFile(IList<ArraySegment<byte>> head, string fileName, long offset, long count, ArraySegment<byte> tail)
+        {
+            try
+            {
+                // Caller reuses head list after send starts, so it must be copied before first await
+                var buffers = new ArraySegment<byte>[head.Count];
+                head.CopyTo(buffers, 0);
+                ContinueWithFinishSend(WriteSequentiallyAsync(buffers, fileName, offset, count, tail));
+            }
+            catch (Exception ex)
+            {
+                _next.FinishSend(ex);
+            }
+        }
+
+        // Encryption needs data in managed memory so file content is streamed through SslStream
+        async Task WriteSequentiallyAsync(ArraySegment<byte>[] buffers, string fileName, long offset, long count, ArraySegment<byte> tail)
+        {
+            foreach (var buffer in buffers)
+            {
+                await _ssl.WriteAsync(buffer.Array, buffer.Offset, buffer.Count);
+            }
+            if (fileName != null)
+            {
+                using (var file = new FileStream(fileName, FileMode.Open, FileAccess.Read, FileShare.Read, 4096, true))
                 {
-                    var self = (SslTransportHandler)selfObject;
-                    if (t.IsCanceled)
-                    {
-                        self._next.FinishSend(new OperationCanceledException());
-                    }
-                    else if (t.IsFaulted)
-                    {
-                        self._next.FinishSend(t.Exception);
-                    }
-                    else
+                    file.Position = offset;
+                    var fileBuffer = _fileBuffer ?? (_fileBuffer = new byte[16384]);
+                    while (count > 0)
                     {
-                        self._next.FinishSend(null);
+                        var read = await file.ReadAsync(fileBuffer, 0, (int)Math.Min(fileBuffer.Length, count));
+                        if (read == 0) throw new EndOfStreamException();
+                        await _ssl.WriteAsync(fileBuffer, 0, read);
+                        count -= read;
                     }
-                }, this);
+                }
             }
-            catch (Exception ex)
+            if (tail.Array != null)
             {
-                _next.FinishSend(ex);
+                await _ssl.WriteAsync(tail.Array, tail.Offset, tail.Count);
             }
         }
 
+        void ContinueWithFinishSend(Task task)
+        {
+            task.ContinueWith((t, selfObject) =>
+            {
+                var self = (SslTransportHandler)selfObject;
+                if (t.IsCanceled)
+                {
+                    self._next.FinishSend(new OperationCanceledException());
+                }
+                else if (t.IsFaulted)
+                {
+                    self._next.FinishSend(t.Exception);
+                }
+                else
+                {
+                    self._next.FinishSend(null);
+                }
+            }, this);
+        }
+
         public void StartDisconnect()
         {
             Callback.StartDisconnect();
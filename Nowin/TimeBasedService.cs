@@ -5,31 +5,36 @@ namespace Nowin
 {
     public class TimeBasedService : ITimeBasedService, IDisposable
     {
-        readonly uint _timeOut;
         readonly Timer _timer;
+        readonly TimeoutWheel _timeouts = new TimeoutWheel();
         volatile string _dateHeaderValue;
-        volatile uint _currentSecond;
 
-        public TimeBasedService(uint timeOut)
+        public TimeBasedService()
         {
-            _timeOut = timeOut;
-            _currentSecond = 0;
             Update(null);
             _timer = new Timer(Update, null, 1000, 1000);
         }
 
+        [Obsolete("Connection timeouts are configured by ServerBuilder, timeOut is ignored")]
+        public TimeBasedService(uint timeOut) : this()
+        {
+        }
+
         void Update(object state)
         {
             var now = DateTime.UtcNow;
-            _currentSecond++;
             _dateHeaderValue = now.ToString("r");
+            _timeouts.Advance();
         }
 
         public string DateHeaderValue => _dateHeaderValue;
 
+        // Driven by same one second tick as Date header
+        internal TimeoutWheel Timeouts => _timeouts;
+
         public void Dispose()
         {
             _timer.Dispose();
         }
     }
-}
\ No newline at end of file
+}
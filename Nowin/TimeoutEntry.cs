@@ -0,0 +1,22 @@
+using System;
+
+namespace Nowin
+{
+    // One per connection for its whole life, so arming timeout never allocates
+    class TimeoutEntry
+    {
+        internal readonly Action Expired;
+        // Second in which connection expires, 0 means disarmed. Written without lock by owner.
+        internal int Deadline;
+        // Fields below are guarded by wheel lock, Linked and SlotTime are also read without it
+        internal int Linked;
+        internal int SlotTime;
+        internal TimeoutEntry Next;
+        internal TimeoutEntry Prev;
+
+        internal TimeoutEntry(Action expired)
+        {
+            Expired = expired;
+        }
+    }
+}
@@ -0,0 +1,154 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Threading;
+
+namespace Nowin
+{
+    // Hashed timer wheel with one second resolution. Entries are placed lazily: moving deadline later
+    // (common keep-alive case) only stores it and entry is moved when wheel reaches its current slot.
+    // Only deadline earlier than slot entry waits in takes lock.
+    class TimeoutWheel
+    {
+        const int SlotCount = 64;
+        const int SlotMask = SlotCount - 1;
+
+        readonly TimeoutEntry[] _slots = new TimeoutEntry[SlotCount];
+        readonly List<TimeoutEntry> _expired = new List<TimeoutEntry>();
+        readonly object _lock = new object();
+        // Timer callbacks could overlap when timer thread is late, they share _expired list
+        readonly object _advanceLock = new object();
+        // Starts at 1 so 0 deadline could mean disarmed
+        volatile int _now = 1;
+
+        internal int Now => _now;
+
+        internal void Arm(TimeoutEntry entry, int seconds)
+        {
+            var deadline = _now + seconds;
+            // Full fence pairs with Advance which publishes Linked and SlotTime before rereading Deadline
+            Interlocked.Exchange(ref entry.Deadline, deadline);
+            if (Volatile.Read(ref entry.Linked) != 0 && deadline >= Volatile.Read(ref entry.SlotTime)) return;
+            lock (_lock)
+            {
+                if (entry.Linked != 0)
+                {
+                    if (Volatile.Read(ref entry.Deadline) >= entry.SlotTime) return;
+                    Unlink(entry);
+                }
+                Place(entry);
+            }
+        }
+
+        internal static void Disarm(TimeoutEntry entry)
+        {
+            Volatile.Write(ref entry.Deadline, 0);
+        }
+
+        internal void Advance()
+        {
+            lock (_advanceLock)
+            {
+                AdvanceAndCollectExpired();
+                // Aborting connection could run application callbacks or next request inline, that must not stall shared timer thread
+                for (var i = 0; i < _expired.Count; i++)
+                {
+                    ThreadPool.UnsafeQueueUserWorkItem(RunExpiredCallback, _expired[i]);
+                }
+                _expired.Clear();
+            }
+        }
+
+        static readonly WaitCallback RunExpiredCallback = RunExpired;
+
+        static void RunExpired(object state)
+        {
+            try
+            {
+                ((TimeoutEntry)state).Expired();
+            }
+            catch (Exception ex)
+            {
+                TraceSources.Core.TraceEvent(TraceEventType.Error, 0, "Aborting timed out connection failed {0}", ex);
+            }
+        }
+
+        void AdvanceAndCollectExpired()
+        {
+            lock (_lock)
+            {
+                var now = _now + 1;
+                _now = now;
+                var entry = _slots[now & SlotMask];
+                _slots[now & SlotMask] = null;
+                while (entry != null)
+                {
+                    var next = entry.Next;
+                    entry.Next = null;
+                    entry.Prev = null;
+                    Process(entry, now);
+                    entry = next;
+                }
+            }
+        }
+
+        void Process(TimeoutEntry entry, int now)
+        {
+            while (true)
+            {
+                var deadline = Volatile.Read(ref entry.Deadline);
+                if (deadline != 0 && deadline <= now)
+                {
+                    // Lost race with owner rearming or disarming it, so decide again
+                    if (Interlocked.CompareExchange(ref entry.Deadline, 0, deadline) != deadline) continue;
+                    _expired.Add(entry);
+                }
+                else if (deadline != 0)
+                {
+                    Place(entry);
+                    return;
+                }
+                Interlocked.Exchange(ref entry.Linked, 0);
+                // Owner could rearm after seeing entry still linked
+                if (Volatile.Read(ref entry.Deadline) == 0) return;
+            }
+        }
+
+        // Entry waits in slot of its deadline, but at most one turn of wheel ahead
+        void Place(TimeoutEntry entry)
+        {
+            var now = _now;
+            while (true)
+            {
+                var deadline = Volatile.Read(ref entry.Deadline);
+                if (deadline == 0)
+                {
+                    Interlocked.Exchange(ref entry.Linked, 0);
+                    if (Volatile.Read(ref entry.Deadline) == 0) return;
+                    continue;
+                }
+                var slotTime = Math.Max(now + 1, Math.Min(deadline, now + SlotCount));
+                Interlocked.Exchange(ref entry.SlotTime, slotTime);
+                Interlocked.Exchange(ref entry.Linked, 1);
+                // Earlier deadline stored by owner after it saw old SlotTime must not be missed
+                var current = Volatile.Read(ref entry.Deadline);
+                if (current != deadline && current < slotTime) continue;
+                var head = _slots[slotTime & SlotMask];
+                entry.Next = head;
+                if (head != null) head.Prev = entry;
+                _slots[slotTime & SlotMask] = entry;
+                return;
+            }
+        }
+
+        void Unlink(TimeoutEntry entry)
+        {
+            if (entry.Prev != null) entry.Prev.Next = entry.Next;
+            else _slots[entry.SlotTime & SlotMask] = entry.Next;
+            if (entry.Next != null) entry.Next.Prev = entry.Prev;
+            entry.Next = null;
+            entry.Prev = null;
+            entry.Linked = 0;
+        }
+    }
+}
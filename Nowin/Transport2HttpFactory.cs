@@ -12,15 +12,19 @@ public class Transport2HttpFactory : ILayerFactory
         readonly IIpIsLocalChecker _ipIsLocalChecker;
         readonly ILayerFactory _next;
         readonly ThreadLocal<char[]> _charBuffer;
-        static readonly ITimeBasedService _dateProvider = new TimeBasedService(0);
+        readonly ServerMetrics _metrics;
+        readonly ConnectionTimeouts _timeouts;
+        static readonly TimeBasedService _dateProvider = new TimeBasedService();
 
-        public Transport2HttpFactory(int receiveBufferSize, bool isSsl, string serverName, IIpIsLocalChecker ipIsLocalChecker, ILayerFactory next)
+        public Transport2HttpFactory(int receiveBufferSize, bool isSsl, string serverName, IIpIsLocalChecker ipIsLocalChecker, ILayerFactory next, ServerMetrics metrics = null, ConnectionTimeouts timeouts = null)
         {
             _receiveBufferSize = receiveBufferSize;
             _isSsl = isSsl;
             _serverName = serverName;
             _ipIsLocalChecker = ipIsLocalChecker;
             _next = next;
+            _metrics = metrics;
+            _timeouts = timeouts;
             _charBuffer = new ThreadLocal<char[]>(()=>new char[receiveBufferSize]);
             PerConnectionBufferSize = MyPerConnectionBufferSize() + _next.PerConnectionBufferSize;
         }
@@ -48,7 +52,7 @@ public void InitCommonBuffer(byte[] buffer, int offset)
         public ILayerHandler Create(byte[] buffer, int offset, int commonOffset, int handlerId)
         {
             var nextHandler = (IHttpLayerHandler)_next.Create(buffer, offset + MyPerConnectionBufferSize(), commonOffset + MyCommonBufferSize(), handlerId);
-            return new Transport2HttpHandler(nextHandler, _isSsl, _serverName, _dateProvider, _ipIsLocalChecker, buffer, offset, _receiveBufferSize, commonOffset, _charBuffer, handlerId);
+            return new Transport2HttpHandler(nextHandler, _isSsl, _serverName, _dateProvider, _ipIsLocalChecker, buffer, offset, _receiveBufferSize, commonOffset, _charBuffer, handlerId, _metrics, _timeouts != null ? _dateProvider.Timeouts : null, _timeouts);
         }
     }
 }
\ No newline at end of file
@@ -34,7 +34,12 @@ class Transport2HttpHandler : ITransportLayerHandler, IHttpLayerCallback
         readonly ITimeBasedService _dateProvider;
         readonly IIpIsLocalChecker _ipIsLocalChecker;
         readonly ReqRespStream _reqRespStream;
+        readonly string[] _lastHeaderValues = new string[KnownHeaders.SlotCount];
         volatile TaskCompletionSource<bool> _tcsSend;
+        readonly List<ArraySegment<byte>> _sendSegments = new List<ArraySegment<byte>>(5);
+        // 16 hex digits for ulong and CRLF
+        readonly byte[] _chunkHeader = new byte[18];
+        static readonly ArraySegment<byte> CrLfSegment = new ArraySegment<byte>(new byte[] { 13, 10 });
         CancellationTokenSource _cancellation;
         int _responseHeaderPos;
         int _acceptCounter;
@@ -62,6 +67,34 @@ class Transport2HttpHandler : ITransportLayerHandler, IHttpLayerCallback
         readonly ThreadLocal<char[]> _charBuffer;
         readonly int _handlerId;
         readonly object _receiveProcessingLock = new object();
+        readonly ServerMetrics _metrics;
+        // Stage start timestamps, 0 when metrics are disabled, request is not sampled or stage is not running
+        long _waitForRequestTimestamp;
+        bool _waitForRequestIsKeepAlive;
+        long _requestReceivedTimestamp;
+        long _appTimestamp;
+        long _sendTimestamp;
+        // Stage latencies are measured only on sampled requests, countdown survives connections of this slot
+        bool _timedRequest;
+        int _latencySampleCountdown = 1;
+        bool _abortReported;
+        readonly TimeoutWheel _timeoutWheel;
+        readonly ConnectionTimeouts _timeouts;
+        readonly TimeoutEntry _timeoutEntry;
+        volatile TimeoutState _timeoutState;
+        // Request body rate is measured only in seconds spent waiting for data
+        int _requestBodyWaitStart;
+        int _requestBodyWaited;
+        long _requestBodyReceived;
+        bool _requestBodyTimedOut;
+
+        enum TimeoutState
+        {
+            None,
+            KeepAlive,
+            RequestHead,
+            RequestBody
+        }
         
         [Flags]
         enum WebSocketReqConditions
@@ -87,7 +120,7 @@ enum WebSocketReqConditions
         bool _dateOverwrite;
         bool _startedReceiveRequestData;
 
-        public Transport2HttpHandler(IHttpLayerHandler next, bool isSsl, string serverName, ITimeBasedService dateProvider, IIpIsLocalChecker ipIsLocalChecker, byte[] buffer, int startBufferOffset, int receiveBufferSize, int constantsOffset, ThreadLocal<char[]> charBuffer, int handlerId)
+        public Transport2HttpHandler(IHttpLayerHandler next, bool isSsl, string serverName, ITimeBasedService dateProvider, IIpIsLocalChecker ipIsLocalChecker, byte[] buffer, int startBufferOffset, int receiveBufferSize, int constantsOffset, ThreadLocal<char[]> charBuffer, int handlerId, ServerMetrics metrics, TimeoutWheel timeoutWheel, ConnectionTimeouts timeouts)
         {
             _next = next;
             StartBufferOffset = startBufferOffset;
@@ -96,6 +129,10 @@ public Transport2HttpHandler(IHttpLayerHandler next, bool isSsl, string serverNa
             _constantsOffset = constantsOffset;
             _charBuffer = charBuffer;
             _handlerId = handlerId;
+            _metrics = metrics;
+            _timeoutWheel = timeoutWheel;
+            _timeouts = timeouts;
+            if (timeoutWheel != null) _timeoutEntry = new TimeoutEntry(ConnectionTimedOut);
             _buffer = buffer;
             _isSsl = isSsl;
             _serverName = serverName;
@@ -109,6 +146,7 @@ public Transport2HttpHandler(IHttpLayerHandler next, bool isSsl, string serverNa
         internal void StartNextRequestDataReceive()
         {
             _startedReceiveRequestData = true;
+            ArmRequestBodyTimeout();
             StartNextReceive();
         }
 
@@ -142,6 +180,7 @@ void ParseRequest(byte[] buffer, int startBufferOffset, int posOfReqEnd)
         bool ParseHttpHeaders(byte[] buffer, int pos, int posOfReqEnd)
         {
             var name = "";
+            var slot = -1;
             while (pos < posOfReqEnd)
             {
                 int start;
@@ -149,16 +188,16 @@ bool ParseHttpHeaders(byte[] buffer, int pos, int posOfReqEnd)
                 if (!IsSpaceOrTab(buffer[pos]))
                 {
                     start = pos;
-                    SkipTokenChars(buffer, ref pos);
+                    RequestHeadScanner.SkipTokenChars(buffer, ref pos);
                     if (buffer[pos] != ':') return false;
-                    name = StringFromLatin1(buffer, start, pos);
+                    name = KnownHeaders.TryGetName(buffer, start, pos, out slot) ?? StringFromLatin1(buffer, start, pos);
                     newHeaderKey = true;
                 }
                 pos++;
                 SkipSpacesOrTabs(buffer, ref pos);
                 start = pos;
-                SkipToCR(buffer, ref pos);
-                var value = StringFromLatin1(buffer, start, pos);
+                RequestHeadScanner.SkipToCR(buffer, ref pos);
+                var value = HeaderValueFromLatin1(buffer, start, pos, slot);
                 if (newHeaderKey)
                     ProcessRequestHeader(name, value);
                 else
@@ -168,87 +207,103 @@ bool ParseHttpHeaders(byte[] buffer, int pos, int posOfReqEnd)
             return true;
         }
 
+        string HeaderValueFromLatin1(byte[] buffer, int start, int end, int slot)
+        {
+            var value = KnownHeaders.TryGetValue(buffer, start, end);
+            if (value != null) return value;
+            if (slot < 0) return StringFromLatin1(buffer, start, end);
+            // Same client usually sends same values on keep-alive connection (Cookie, User-Agent, ...)
+            value = _lastHeaderValues[slot];
+            if (value != null && value.Length == end - start && RequestHeadScanner.EqualsLatin1(value, buffer, start))
+                return value;
+            value = StringFromLatin1(buffer, start, end);
+            _lastHeaderValues[slot] = value;
+            return value;
+        }
+
         void ProcessRequestHeader(string name, string value)
         {
-            if (name.Equals("Connection", StringComparison.OrdinalIgnoreCase))
+            switch (name.Length)
             {
-                if (_isHttp10)
-                {
-                    if (value.Equals("Keep-Alive", StringComparison.OrdinalIgnoreCase))
+                case 10:
+                    if (name.Equals("Connection", StringComparison.OrdinalIgnoreCase))
+                        ProcessConnectionHeader(value);
+                    break;
+                case 6:
+                    if (name.Equals("Expect", StringComparison.OrdinalIgnoreCase))
                     {
-                        _isKeepAlive = true;
+                        if (value.Equals("100-Continue", StringComparison.OrdinalIgnoreCase))
+                        {
+                            ShouldSend100Continue = true;
+                        }
                     }
-                }
-                else
-                {
-                    if (value.Equals("Close", StringComparison.OrdinalIgnoreCase))
+                    break;
+                case 14:
+                    if (name.Equals("Content-Length", StringComparison.OrdinalIgnoreCase))
+                    {
+                        if (!ulong.TryParse(value, out RequestContentLength))
+                        {
+                            throw new InvalidDataException($"Wrong request content length: {value}");
+                        }
+                    }
+                    break;
+                case 17:
+                    if (name.Equals("Transfer-Encoding", StringComparison.OrdinalIgnoreCase))
                     {
-                        _isKeepAlive = false;
+                        if (value.Equals("chunked", StringComparison.OrdinalIgnoreCase))
+                        {
+                            RequestIsChunked = true;
+                            RequestContentLength = ulong.MaxValue;
+                        }
                     }
-                    else if (value.IndexOf("Upgrade", StringComparison.OrdinalIgnoreCase) >= 0)
+                    else if (name.Equals("Sec-WebSocket-Key", StringComparison.OrdinalIgnoreCase))
                     {
-                        _webSocketReqCondition |= WebSocketReqConditions.ConnectionUpgrade;
+                        _webSocketReqCondition |= WebSocketReqConditions.ValidKey;
+                        _webSocketKey = value;
                     }
-                }
-            }
-            else if (name.Equals("Expect", StringComparison.OrdinalIgnoreCase))
-            {
-                if (value.Equals("100-Continue", StringComparison.OrdinalIgnoreCase))
-                {
-                    ShouldSend100Continue = true;
-                }
-            }
-            else if (name.Equals("Content-Length", StringComparison.OrdinalIgnoreCase))
-            {
-                if (!ulong.TryParse(value, out RequestContentLength))
-                {
-                    throw new InvalidDataException($"Wrong request content length: {value}");
-                }
+                    break;
+                case 7:
+                    if (name.Equals("Upgrade", StringComparison.OrdinalIgnoreCase))
+                    {
+                        if (value.Equals("websocket", StringComparison.OrdinalIgnoreCase))
+                        {
+                            _webSocketReqCondition |= WebSocketReqConditions.UpgradeWebSocket;
+                        }
+                    }
+                    break;
+                case 21:
+                    if (name.Equals("Sec-WebSocket-Version", StringComparison.OrdinalIgnoreCase))
+                    {
+                        if (value == "13")
+                        {
+                            _webSocketReqCondition |= WebSocketReqConditions.Version13;
+                        }
+                    }
+                    break;
             }
-            else if (name.Equals("Transfer-Encoding", StringComparison.OrdinalIgnoreCase))
+            _next.AddRequestHeader(name, value);
+        }
+
+        void ProcessConnectionHeader(string value)
+        {
+            if (_isHttp10)
             {
-                if (value.Equals("chunked", StringComparison.OrdinalIgnoreCase))
+                if (value.Equals("Keep-Alive", StringComparison.OrdinalIgnoreCase))
                 {
-                    RequestIsChunked = true;
-                    RequestContentLength = ulong.MaxValue;
+                    _isKeepAlive = true;
                 }
             }
-            else if (name.Equals("Upgrade", StringComparison.OrdinalIgnoreCase))
+            else
             {
-                if (value.Equals("websocket", StringComparison.OrdinalIgnoreCase))
+                if (value.Equals("Close", StringComparison.OrdinalIgnoreCase))
                 {
-                    _webSocketReqCondition |= WebSocketReqConditions.UpgradeWebSocket;
+                    _isKeepAlive = false;
                 }
-            }
-            else if (name.Equals("Sec-WebSocket-Version", StringComparison.OrdinalIgnoreCase))
-            {
-                if (value == "13")
+                else if (value.IndexOf("Upgrade", StringComparison.OrdinalIgnoreCase) >= 0)
                 {
-                    _webSocketReqCondition |= WebSocketReqConditions.Version13;
+                    _webSocketReqCondition |= WebSocketReqConditions.ConnectionUpgrade;
                 }
             }
-            else if (name.Equals("Sec-WebSocket-Key", StringComparison.OrdinalIgnoreCase))
-            {
-                _webSocketReqCondition |= WebSocketReqConditions.ValidKey;
-                _webSocketKey = value;
-            }
-            _next.AddRequestHeader(name, value);
-        }
-
-        void SkipToCR(byte[] buffer, ref int pos)
-        {
-            while (buffer[pos] != 13) pos++;
-        }
-
-        static void SkipTokenChars(byte[] buffer, ref int pos)
-        {
-            while (true)
-            {
-                var ch = buffer[pos];
-                if (ch <= 32) break;
-                if (ch == ':') break;
-                pos++;
-            }
         }
 
         static void SkipSpacesOrTabs(byte[] buffer, ref int pos)
@@ -298,7 +353,7 @@ void ParseHttpProtocol(byte[] buffer, ref int pos, out string reqProtocol)
                 return;
             }
             var p = pos;
-            SearchForFirstSpaceOrEndOfLine(buffer, ref p);
+            RequestHeadScanner.SearchForFirstSpaceOrEndOfLine(buffer, ref p);
             reqProtocol = StringFromLatin1(buffer, pos, p);
             throw new InvalidDataException($"Unsupported request protocol: {reqProtocol}");
         }
@@ -311,30 +366,30 @@ void ParseHttpPath(byte[] buffer, ref int pos, out string reqPath, out string re
             if (buffer[p] == '/')
             {
                 p++;
-                switch (SearchForFirstSpaceOrQuestionMarkOrEndOfLine(buffer, ref p))
+                switch (RequestHeadScanner.SearchForFirstSpaceOrQuestionMarkOrEndOfLine(buffer, ref p))
                 {
                     case (byte)' ':
-                        reqPath = ParsePath(buffer, start, p);
+                        reqPath = ParsePath(buffer, start, p, _requestPath);
                         reqQueryString = "";
                         pos = p + 1;
                         return;
                     case 13:
-                        reqPath = ParsePath(buffer, start, p);
+                        reqPath = ParsePath(buffer, start, p, _requestPath);
                         reqQueryString = "";
                         pos = p;
                         return;
                     case (byte)'?':
-                        reqPath = ParsePath(buffer, start, p);
+                        reqPath = ParsePath(buffer, start, p, _requestPath);
                         p++;
                         start = p;
-                        switch (SearchForFirstSpaceOrEndOfLine(buffer, ref p))
+                        switch (RequestHeadScanner.SearchForFirstSpaceOrEndOfLine(buffer, ref p))
                         {
                             case (byte)' ':
-                                reqQueryString = ParsePath(buffer, start, p);
+                                reqQueryString = ParsePath(buffer, start, p, _requestQueryString);
                                 pos = p + 1;
                                 return;
                             case 13:
-                                reqQueryString = ParsePath(buffer, start, p);
+                                reqQueryString = ParsePath(buffer, start, p, _requestQueryString);
                                 pos = p;
                                 return;
                             default:
@@ -359,7 +414,8 @@ char[] GetCharBuffer()
             return _charBuffer.Value;
         }
 
-        string ParsePath(byte[] buffer, int start, int end)
+        // previous is value from last request on this connection, it is returned instead of new string when decoded path is same
+        string ParsePath(byte[] buffer, int start, int end, string previous)
         {
             var chs = GetCharBuffer();
             var used = 0;
@@ -446,35 +502,26 @@ string ParsePath(byte[] buffer, int start, int end)
             {
                 chs[used++] = '?';
             }
-            return new string(chs, 0, used);
+            return StringFromChars(chs, used, previous);
         }
 
-        public static int ParseHexChar(byte ch)
+        static string StringFromChars(char[] chs, int used, string previous)
         {
-            if (ch >= '0' && ch <= '9') return ch - '0';
-            if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
-            if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
-            return -1;
-        }
-
-        static byte SearchForFirstSpaceOrEndOfLine(byte[] buffer, ref int p)
-        {
-            while (true)
+            if (used == 0) return "";
+            if (previous == null || previous.Length != used) return new string(chs, 0, used);
+            for (var i = 0; i < used; i++)
             {
-                var ch = buffer[p];
-                if (ch == ' ' || ch == 13) return ch;
-                p++;
+                if (chs[i] != previous[i]) return new string(chs, 0, used);
             }
+            return previous;
         }
 
-        static byte SearchForFirstSpaceOrQuestionMarkOrEndOfLine(byte[] buffer, ref int p)
+        public static int ParseHexChar(byte ch)
         {
-            while (true)
-            {
-                var ch = buffer[p];
-                if (ch == ' ' || ch == '?' || ch == 13) return ch;
-                p++;
-            }
+            if (ch >= '0' && ch <= '9') return ch - '0';
+            if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+            if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+            return -1;
         }
 
         string ParseHttpMethod(byte[] buffer, ref int pos)
@@ -589,6 +636,7 @@ void FillResponse(bool finished)
                 }
                 _responseContentLength = _reqRespStream.ResponseLength;
             }
+            _metrics?.RecordStatusCode(status);
             _responseHeaderPos = 0;
             HeaderAppend("HTTP/1.1 ");
             HeaderAppendHttpStatus(status);
@@ -701,6 +749,24 @@ void HeaderAppend(string text)
             _responseHeaderPos += text.Length;
         }
 
+        void HeaderAppendNumber(int value)
+        {
+            var digits = 1;
+            for (var v = value; v >= 10; v /= 10) digits++;
+            if (_responseHeaderPos > ReceiveBufferSize - digits)
+            {
+                _responseHeaderPos += digits;
+                return;
+            }
+            var j = StartBufferOffset + ReceiveBufferSize + _responseHeaderPos + digits;
+            do
+            {
+                _buffer[--j] = (byte)('0' + value % 10);
+                value /= 10;
+            } while (value > 0);
+            _responseHeaderPos += digits;
+        }
+
         void NormalizeReceiveBuffer()
         {
             if (ReceiveBufferPos == 0) return;
@@ -711,6 +777,7 @@ void NormalizeReceiveBuffer()
 
         void SendHttpResponseAndPrepareForNext()
         {
+            if (_timedRequest && _sendTimestamp == 0) _sendTimestamp = ServerMetrics.Timestamp();
             var offset = _reqRespStream.ResponseStartOffset;
             var len = _reqRespStream.ResponseLocalPos;
             if (_isMethodHead)
@@ -745,17 +812,23 @@ void SendHttpResponseAndPrepareForNext()
             var tcs = _tcsSend;
             if (tcs != null)
             {
-                tcs.Task.ContinueWith(_ =>
-                    {
-                        _lastPacket = true;
-                        Callback.StartSend(_buffer, offset, len);
-                    });
+                SendLastPacketAfter(tcs.Task, offset, len);
                 return;
             }
             _lastPacket = true;
             Callback.StartSend(_buffer, offset, len);
         }
 
+        // Lambdas capturing locals are in separate methods so common path without pending send does not allocate closure
+        void SendLastPacketAfter(Task previousSend, int offset, int len)
+        {
+            previousSend.ContinueWith(_ =>
+                {
+                    _lastPacket = true;
+                    Callback.StartSend(_buffer, offset, len);
+                });
+        }
+
         static void AppendZeroChunk(byte[] buffer, int offset, ref int len)
         {
             offset += len;
@@ -786,6 +859,7 @@ void SendInternalServerError(string response = "500 Internal Server Error")
             }
             _isKeepAlive = false;
             _lastPacket = true;
+            _metrics?.RecordStatusCode((response[0] - '0') * 100);
             try
             {
                 response = "HTTP/1.1 " + response + "\r\nServer: " + _serverName + "\r\nDate: " + _dateProvider.DateHeaderValue + "\r\nContent-Length: 0\r\n\r\n";
@@ -798,27 +872,6 @@ void SendInternalServerError(string response = "500 Internal Server Error")
             }
         }
 
-        static int FindRequestEnd(byte[] buffer, int start, int end)
-        {
-            var pos = start;
-            while (pos < end)
-            {
-                var ch = buffer[pos++];
-                if (ch != 13) continue;
-                if (pos >= end) break;
-                ch = buffer[pos++];
-                if (ch != 10) continue;
-                if (pos >= end) break;
-                ch = buffer[pos++];
-                if (ch != 13) continue;
-                if (pos >= end) break;
-                ch = buffer[pos++];
-                if (ch != 10) continue;
-                return pos;
-            }
-            return -1;
-        }
-
         void ResetForNextRequest()
         {
             _waitingForRequest = true;
@@ -865,17 +918,7 @@ public Task WriteAsync(byte[] buffer, int startOffset, int len)
             var tcs = _tcsSend;
             if (tcs != null)
             {
-                return tcs.Task.ContinueWith(_ =>
-                {
-                    tcs = new TaskCompletionSource<bool>();
-                    Thread.MemoryBarrier();
-                    if (_tcsSend != null)
-                    {
-                        throw new InvalidOperationException("Want to start send but previous is still sending");
-                    }
-                    _tcsSend = tcs;
-                    Callback.StartSend(buffer, startOffset, len);
-                });
+                return WriteAfter(tcs.Task, buffer, startOffset, len);
             }
             tcs = new TaskCompletionSource<bool>();
             Thread.MemoryBarrier();
@@ -884,6 +927,23 @@ public Task WriteAsync(byte[] buffer, int startOffset, int len)
             return tcs.Task;
         }
 
+        // Completes when queued send finishes, not when it starts, so caller cannot reuse buffer still being sent
+        Task WriteAfter(Task previousSend, byte[] buffer, int startOffset, int len)
+        {
+            return previousSend.ContinueWith(_ =>
+            {
+                var tcs = new TaskCompletionSource<bool>();
+                Thread.MemoryBarrier();
+                if (_tcsSend != null)
+                {
+                    throw new InvalidOperationException("Want to start send but previous is still sending");
+                }
+                _tcsSend = tcs;
+                Callback.StartSend(buffer, startOffset, len);
+                return tcs.Task;
+            }).Unwrap();
+        }
+
         static void WrapInChunk(byte[] buffer, ref int startOffset, ref int len)
         {
             var l = (uint)len;
@@ -919,6 +979,113 @@ static void OptimallyMergeTwoRegions(byte[] buffer, int o1, int l1, ref int o2,
             l2 += l1;
         }
 
+        public Task WriteGatherAsync(int bufferedLength, byte[] buffer, int offset, int count)
+        {
+            if (PrepareGather(bufferedLength, (ulong)count))
+            {
+                _sendSegments.Add(new ArraySegment<byte>(buffer, offset, count));
+                if (_responseIsChunked)
+                    _sendSegments.Add(CrLfSegment);
+            }
+            return StartGatherSend(null, 0, 0);
+        }
+
+        public Task WriteFileAsync(int bufferedLength, string fileName, long offset, long count)
+        {
+            if (!PrepareGather(bufferedLength, (ulong)count))
+                fileName = null;
+            return StartGatherSend(fileName, offset, count);
+        }
+
+        // Collects response headers, chunk header and already buffered body into _sendSegments without merging them into one region.
+        // Returns false when body must not be sent.
+        bool PrepareGather(int bufferedLength, ulong count)
+        {
+            _sendSegments.Clear();
+            if (!_responseHeadersSend)
+            {
+                FillResponse(false);
+                if (_responseHeaderPos > ReceiveBufferSize) throw new ArgumentException(
+                    $"Response headers are longer({_responseHeaderPos}) than buffer({ReceiveBufferSize})");
+                _sendSegments.Add(new ArraySegment<byte>(_buffer, StartBufferOffset + ReceiveBufferSize, _responseHeaderPos));
+                _responseHeadersSend = true;
+            }
+            if (_isMethodHead)
+                return false;
+            if (_responseContentLength != ulong.MaxValue && _reqRespStream.ResponseLength > _responseContentLength)
+            {
+                CloseConnection();
+                throw new ArgumentOutOfRangeException(nameof(count), "Cannot send more bytes than specified in Content-Length header");
+            }
+            if (_responseIsChunked)
+            {
+                // Pending send could still read _chunkHeader, so send queued after it gets its own
+                var chunkHeader = _tcsSend == null ? _chunkHeader : new byte[_chunkHeader.Length];
+                var chunkHeaderStart = FormatChunkHeader(chunkHeader, (ulong)bufferedLength + count);
+                _sendSegments.Add(new ArraySegment<byte>(chunkHeader, chunkHeaderStart, chunkHeader.Length - chunkHeaderStart));
+            }
+            if (bufferedLength > 0)
+                _sendSegments.Add(new ArraySegment<byte>(_buffer, _reqRespStream.ResponseStartOffset, bufferedLength));
+            return true;
+        }
+
+        static int FormatChunkHeader(byte[] chunkHeader, ulong len)
+        {
+            var o = chunkHeader.Length - 2;
+            chunkHeader[o] = 13;
+            chunkHeader[o + 1] = 10;
+            do
+            {
+                var h = (uint)(len & 15);
+                if (h < 10) h += '0'; else h += 'A' - 10;
+                chunkHeader[--o] = (byte)h;
+                len /= 16;
+            } while (len > 0);
+            return o;
+        }
+
+        Task StartGatherSend(string fileName, long offset, long count)
+        {
+            if (_sendSegments.Count == 0 && fileName == null)
+                return Task.Delay(0);
+            var tcs = _tcsSend;
+            if (tcs != null)
+            {
+                // _sendSegments is cleared by next gather before queued send starts
+                return GatherSendAfter(tcs.Task, _sendSegments.ToArray(), fileName, offset, count);
+            }
+            tcs = new TaskCompletionSource<bool>();
+            Thread.MemoryBarrier();
+            _tcsSend = tcs;
+            RealStartGatherSend(_sendSegments, fileName, offset, count);
+            return tcs.Task;
+        }
+
+        // Completes when queued send finishes, not when it starts, because segments reference caller buffer without copying
+        Task GatherSendAfter(Task previousSend, IList<ArraySegment<byte>> segments, string fileName, long offset, long count)
+        {
+            return previousSend.ContinueWith(_ =>
+            {
+                var tcs = new TaskCompletionSource<bool>();
+                Thread.MemoryBarrier();
+                if (_tcsSend != null)
+                {
+                    throw new InvalidOperationException("Want to start send but previous is still sending");
+                }
+                _tcsSend = tcs;
+                RealStartGatherSend(segments, fileName, offset, count);
+                return tcs.Task;
+            }).Unwrap();
+        }
+
+        void RealStartGatherSend(IList<ArraySegment<byte>> segments, string fileName, long offset, long count)
+        {
+            if (fileName == null)
+                Callback.StartSend(segments);
+            else
+                Callback.StartSendFile(segments, fileName, offset, count, _responseIsChunked ? CrLfSegment : default(ArraySegment<byte>));
+        }
+
         public void Send100Continue()
         {
             var tcs = new TaskCompletionSource<bool>();
@@ -979,7 +1146,18 @@ void RealPrepareAccept()
         public void FinishAccept(byte[] buffer, int offset, int length, IPEndPoint remoteEndPoint, IPEndPoint localEndPoint)
         {
             ResetForNextRequest();
+            ArmRequestHeadTimeout();
             ReceiveBufferPos = 0;
+            _abortReported = false;
+            if (_metrics != null)
+            {
+                _timedRequest = _metrics.SampleLatency(ref _latencySampleCountdown);
+                _waitForRequestTimestamp = _timedRequest ? ServerMetrics.Timestamp() : 0;
+                _waitForRequestIsKeepAlive = false;
+                _requestReceivedTimestamp = 0;
+                _appTimestamp = 0;
+                _sendTimestamp = 0;
+            }
             _remoteEndPoint = remoteEndPoint;
             _knownIsLocal = false;
             _remoteIpAddress = null;
@@ -1022,6 +1200,7 @@ public void FinishReceive(byte[] buffer, int offset, int length)
                 }
                 else
                 {
+                    ReportAbort();
                     if (_startedReceiveData)
                     {
                         _startedReceiveData = false;
@@ -1039,6 +1218,10 @@ public void FinishReceive(byte[] buffer, int offset, int length)
             Debug.Assert(StartBufferOffset + ReceiveBufferPos == offset || _waitingForRequest);
             Debug.Assert(_receiveBufferFullness == offset);
             TraceSources.CoreDebug.TraceInformation(Encoding.UTF8.GetString(buffer, offset, length));
+            if (_waitForRequestTimestamp != 0 && length > 0)
+            {
+                _requestReceivedTimestamp = RecordWaitForRequest();
+            }
             var startNextRecv = false;
             lock (_receiveProcessingLock)
             {
@@ -1075,10 +1258,12 @@ bool ProcessReceive()
             {
                 if (_waitingForRequest)
                 {
-                    var posOfReqEnd = FindRequestEnd(_buffer, StartBufferOffset + ReceiveBufferPos, _receiveBufferFullness);
+                    var posOfReqEnd = RequestHeadScanner.FindRequestEnd(_buffer, StartBufferOffset + ReceiveBufferPos, _receiveBufferFullness);
                     if (posOfReqEnd < 0)
                     {
                         NormalizeReceiveBuffer();
+                        // Slow client has limited time for whole head since its first byte
+                        if (_timeoutState == TimeoutState.KeepAlive) ArmRequestHeadTimeout();
                         var count = StartBufferOffset + ReceiveBufferSize - _receiveBufferFullness;
                         if (count == 0)
                         {
@@ -1090,13 +1275,30 @@ bool ProcessReceive()
                     else
                     {
                         _waitingForRequest = false;
+                        DisarmTimeout();
+                        _requestBodyWaited = 0;
+                        _requestBodyReceived = 0;
+                        _requestBodyTimedOut = false;
                         var reenter = false;
                         var currentAcceptCounter = _acceptCounter;
                         try
                         {
                             var peqStartBufferOffset = StartBufferOffset + ReceiveBufferPos;
                             ReceiveBufferPos = posOfReqEnd - StartBufferOffset;
+                            long parseTimestamp = 0;
+                            if (_timedRequest)
+                            {
+                                // Parsing includes searching for end of request head, pipelined request was already in buffer without waiting
+                                parseTimestamp = _waitForRequestTimestamp != 0 ? RecordWaitForRequest() : _requestReceivedTimestamp;
+                                if (parseTimestamp == 0) parseTimestamp = ServerMetrics.Timestamp();
+                                _requestReceivedTimestamp = 0;
+                            }
                             ParseRequest(_buffer, peqStartBufferOffset, posOfReqEnd);
+                            if (_metrics != null)
+                            {
+                                _metrics.Increment(MetricsCounter.Requests);
+                                if (_timedRequest) _appTimestamp = _metrics.RecordSince(MetricsStage.Parse, parseTimestamp);
+                            }
                             var startRealReceive = false;
                             if (ReceiveDataLength == 0 && !_receiving)
                             {
@@ -1178,11 +1380,13 @@ bool ProcessReceive()
                         var currentAcceptCounter = _acceptCounter;
                         try
                         {
+                            if (_timeoutState == TimeoutState.RequestBody) RequestBodyDataReceived(ReceiveDataLength);
                             Monitor.Exit(_receiveProcessingLock);
                             reenter = true;
                             if (_reqRespStream.ProcessDataAndShouldReadMore())
                                 {
                                     _startedReceiveRequestData = true;
+                                    ArmRequestBodyTimeout();
                                 }
                             reenter = false;
                             Monitor.Enter(_receiveProcessingLock);
@@ -1250,6 +1454,7 @@ public void FinishSend(Exception exception)
                 var tcs = _tcsSend;
                 _tcsSend = null;
                 _isKeepAlive = false;
+                ReportAbort();
                 if (tcs != null)
                 {
                     if (exception == null) exception = new EndOfStreamException("Client closed connection");
@@ -1264,9 +1469,22 @@ public void FinishSend(Exception exception)
             if (_lastPacket)
             {
                 _lastPacket = false;
+                long sentTimestamp = 0;
+                if (_sendTimestamp != 0)
+                {
+                    sentTimestamp = _metrics.RecordSince(MetricsStage.Send, _sendTimestamp);
+                    _sendTimestamp = 0;
+                }
                 if (_isKeepAlive && !_clientClosedConnection)
                 {
                     ResetForNextRequest();
+                    ArmKeepAliveTimeout();
+                    if (_metrics != null)
+                    {
+                        _timedRequest = _metrics.SampleLatency(ref _latencySampleCountdown);
+                        _waitForRequestTimestamp = !_timedRequest ? 0 : sentTimestamp != 0 ? sentTimestamp : ServerMetrics.Timestamp();
+                        _waitForRequestIsKeepAlive = true;
+                    }
                     StartNextReceive();
                 }
                 else
@@ -1401,6 +1619,7 @@ public void UpgradeToWebSocket()
                 throw new ArgumentOutOfRangeException();
             }
             _isWebSocket = true;
+            _metrics?.RecordStatusCode(101);
             Callback.StartSend(_buffer, StartBufferOffset + ReceiveBufferSize, _responseHeaderPos);
         }
 
@@ -1413,10 +1632,16 @@ void PrepareResponseHeaders()
 
         public void ResponseFinished()
         {
+            if (_appTimestamp != 0)
+            {
+                _sendTimestamp = _metrics.RecordSince(MetricsStage.App, _appTimestamp);
+                _appTimestamp = 0;
+            }
             if (_statusCode == 599)
             {
                 _cancellation.Cancel();
                 _isKeepAlive = false;
+                ReportAbort();
                 CloseConnection();
                 return;
             }
@@ -1425,10 +1650,14 @@ public void ResponseFinished()
                 _cancellation.Cancel();
                 if (!_responseHeadersSend)
                 {
-                    SendInternalServerError();
+                    if (_requestBodyTimedOut)
+                        SendInternalServerError("408 Request Timeout");
+                    else
+                        SendInternalServerError();
                 }
                 else
                 {
+                    ReportAbort();
                     CloseConnection();
                 }
                 return;
@@ -1450,8 +1679,98 @@ public void ResponseFinished()
             SendHttpResponseAndPrepareForNext();
         }
 
+        long RecordWaitForRequest()
+        {
+            var now = _metrics.RecordSince(_waitForRequestIsKeepAlive ? MetricsStage.KeepAliveIdle : MetricsStage.RequestHead, _waitForRequestTimestamp);
+            _waitForRequestTimestamp = 0;
+            return now;
+        }
+
+        // Counted once per connection
+        void ReportAbort()
+        {
+            if (_metrics == null || _abortReported) return;
+            _abortReported = true;
+            _metrics.Increment(MetricsCounter.ConnectionAborts);
+        }
+
+        void ArmKeepAliveTimeout()
+        {
+            if (_timeoutWheel == null) return;
+            _timeoutState = TimeoutState.KeepAlive;
+            ArmTimeout(_timeouts.KeepAliveSeconds);
+        }
+
+        void ArmRequestHeadTimeout()
+        {
+            if (_timeoutWheel == null) return;
+            _timeoutState = TimeoutState.RequestHead;
+            ArmTimeout(_timeouts.RequestHeadSeconds);
+        }
+
+        // Client must send at least MinRequestBodyDataRate bytes per second of waiting after grace period
+        void ArmRequestBodyTimeout()
+        {
+            if (_timeoutWheel == null || _timeouts.MinRequestBodyDataRate == 0) return;
+            var allowed = Math.Max(_timeouts.RequestBodyGraceSeconds, (int)Math.Min(int.MaxValue / 2, _requestBodyReceived / _timeouts.MinRequestBodyDataRate));
+            _requestBodyWaitStart = _timeoutWheel.Now;
+            _timeoutState = TimeoutState.RequestBody;
+            ArmTimeout(Math.Max(1, allowed - _requestBodyWaited));
+        }
+
+        void RequestBodyDataReceived(int length)
+        {
+            _requestBodyWaited += _timeoutWheel.Now - _requestBodyWaitStart;
+            _requestBodyReceived += length;
+            DisarmTimeout();
+        }
+
+        void ArmTimeout(int seconds)
+        {
+            if (seconds > 0)
+                _timeoutWheel.Arm(_timeoutEntry, seconds);
+            else
+                TimeoutWheel.Disarm(_timeoutEntry);
+        }
+
+        void DisarmTimeout()
+        {
+            if (_timeoutState == TimeoutState.None) return;
+            _timeoutState = TimeoutState.None;
+            TimeoutWheel.Disarm(_timeoutEntry);
+        }
+
+        // Called from thread pool after wheel expired entry, so it could be already rearmed. Aborting makes pending receive fail, so slot is recycled without waiting for client.
+        void ConnectionTimedOut()
+        {
+            lock (_receiveProcessingLock)
+            {
+                var state = _timeoutState;
+                // Rearmed or disarmed while wheel was expiring it
+                if (state == TimeoutState.None || Volatile.Read(ref _timeoutEntry.Deadline) != 0) return;
+                _timeoutState = TimeoutState.None;
+                if (state != TimeoutState.RequestBody)
+                {
+                    if (!_waitingForRequest) return;
+                    TraceSources.CoreDebug.TraceInformation("ID{0,-5} {1} timeout", _handlerId, state);
+                    _metrics?.Increment(MetricsCounter.ConnectionTimeouts);
+                    CloseConnection();
+                    return;
+                }
+                if (!_startedReceiveRequestData) return;
+                _startedReceiveRequestData = false;
+                _requestBodyTimedOut = true;
+            }
+            TraceSources.CoreDebug.TraceInformation("ID{0,-5} RequestBody timeout", _handlerId);
+            _metrics?.Increment(MetricsCounter.ConnectionTimeouts);
+            // Application still owns connection, it is closed after application finishes like when client closes it
+            _cancellation.Cancel();
+            _reqRespStream.ConnectionClosed();
+        }
+
         public void CloseConnection()
         {
+            DisarmTimeout();
             if (Interlocked.CompareExchange(ref _disconnecting, 1, 0) == 0)
                 Callback.StartDisconnect();
         }
@@ -1490,9 +1809,58 @@ public Task SendData(byte[] buffer, int offset, int length)
             return tcs.Task;
         }
 
-        public bool CanUseDirectWrite()
+        public Task SendFileAsync(string fileName, long offset, long? count, CancellationToken cancel)
         {
-            return !_responseIsChunked && _responseHeadersSend;
+            return _reqRespStream.SendFileAsync(fileName, offset, count, cancel);
+        }
+
+        public bool TrySendCachedResponse(byte[] head, int age, byte[] body)
+        {
+            // Connection, Date and Age headers are added per request
+            if (head.Length + 128 > ReceiveBufferSize || _tcsSend != null) return false;
+            if (_appTimestamp != 0)
+            {
+                _sendTimestamp = _metrics.RecordSince(MetricsStage.App, _appTimestamp);
+                _appTimestamp = 0;
+            }
+            if (_timedRequest && _sendTimestamp == 0) _sendTimestamp = ServerMetrics.Timestamp();
+            _metrics?.RecordStatusCode((head[9] - '0') * 100 + (head[10] - '0') * 10 + head[11] - '0');
+            var headerOffset = StartBufferOffset + ReceiveBufferSize;
+            Array.Copy(head, 0, _buffer, headerOffset, head.Length);
+            _responseHeaderPos = head.Length;
+            if (_isHttp10 && _isKeepAlive)
+            {
+                HeaderAppend("Connection: keep-alive\r\n");
+            }
+            if (!_isKeepAlive)
+            {
+                HeaderAppend("Connection: close\r\n");
+            }
+            HeaderAppend("Date: ");
+            HeaderAppend(_dateProvider.DateHeaderValue);
+            HeaderAppendCrLf();
+            if (age > 0)
+            {
+                HeaderAppend("Age: ");
+                HeaderAppendNumber(age);
+                HeaderAppendCrLf();
+            }
+            HeaderAppendCrLf();
+            _responseHeadersSend = true;
+            _lastPacket = true;
+            var bodyLength = _isMethodHead ? 0 : body.Length;
+            if (bodyLength <= SendDataLength - _responseHeaderPos)
+            {
+                Array.Copy(body, 0, _buffer, headerOffset + _responseHeaderPos, bodyLength);
+                Callback.StartSend(_buffer, headerOffset, _responseHeaderPos + bodyLength);
+                return true;
+            }
+            // Body is shared by all connections so it is sent directly from cache
+            _sendSegments.Clear();
+            _sendSegments.Add(new ArraySegment<byte>(_buffer, headerOffset, _responseHeaderPos));
+            _sendSegments.Add(new ArraySegment<byte>(body));
+            Callback.StartSend(_sendSegments);
+            return true;
         }
     }
 }
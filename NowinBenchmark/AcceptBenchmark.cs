@@ -0,0 +1,72 @@
+using System;
+using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Nowin;
+
+namespace NowinBenchmark
+{
+    // Every request uses new connection so accept path dominates, compares single listen socket with SO_REUSEPORT shards
+    static class AcceptBenchmark
+    {
+        const int Port = 8889;
+        static readonly byte[] Request = Encoding.ASCII.GetBytes("GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+
+        public static void Run(int connections)
+        {
+            if (connections == 0) connections = 20000;
+            Run("accept-single", 1, connections);
+            Run("accept-sharded", 0, connections);
+        }
+
+        static void Run(string name, int shards, int connections)
+        {
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env => Task.Delay(0))
+                .SetListenerShards(shards)
+                .SetListenBacklog(1024)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Start())
+            {
+                var clients = Environment.ProcessorCount * 4;
+                var remaining = connections;
+                var allocatedBefore = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize;
+                var sw = Stopwatch.StartNew();
+                var threads = new Thread[clients];
+                for (var i = 0; i < clients; i++)
+                {
+                    threads[i] = new Thread(() =>
+                    {
+                        var response = new byte[1024];
+                        while (Interlocked.Decrement(ref remaining) >= 0)
+                        {
+                            OneConnection(response);
+                        }
+                    });
+                    threads[i].Start();
+                }
+                foreach (var thread in threads) thread.Join();
+                sw.Stop();
+                var allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize - allocatedBefore;
+                Measure.Report(name, connections, sw.Elapsed.TotalMilliseconds * 1e6 / connections, (double)allocated / connections, 0);
+            }
+        }
+
+        static void OneConnection(byte[] response)
+        {
+            using (var socket = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp))
+            {
+                socket.NoDelay = true;
+                socket.Connect(IPAddress.Loopback, Port);
+                socket.Send(Request);
+                while (socket.Receive(response) > 0)
+                {
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Net;
+using System.Text;
+using System.Threading.Tasks;
+using Nowin;
+
+namespace NowinBenchmark
+{
+    // Whole request pipeline including OwinHandler on one in-memory keep-alive connection, reports bytes allocated per request
+    static class AllocationBenchmark
+    {
+        const int ReceiveBufferSize = 8192;
+
+        static readonly string GetRequest =
+            "GET /hello?name=world HTTP/1.1\r\n" +
+            "Host: localhost:8888\r\n" +
+            "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n" +
+            "Accept: text/plain\r\n" +
+            "Accept-Encoding: gzip, deflate, br\r\n" +
+            "Accept-Language: en-US,en;q=0.9\r\n" +
+            "\r\n";
+
+        static readonly string PostRequest =
+            "POST /api/echo HTTP/1.1\r\n" +
+            "Host: localhost:8888\r\n" +
+            "Content-Type: application/json\r\n" +
+            "Content-Length: 26\r\n" +
+            "\r\n" +
+            "{\"id\":1234,\"name\":\"nowin\"}";
+
+        static readonly Task CompletedTask = Task.FromResult(0);
+        static readonly string[] TextPlain = { "text/plain" };
+        static readonly byte[] HelloWorld = Encoding.ASCII.GetBytes("Hello World!");
+
+        public static void Run(int iterations)
+        {
+            if (iterations == 0) iterations = 1000000;
+            Run("alloc-get", GetRequest, iterations, HelloApp, null);
+            Run("alloc-post", PostRequest, iterations, EchoApp(new byte[256]), null);
+            // Application storing its own key in environment, which goes to extra dictionary
+            Run("alloc-get-extra", GetRequest, iterations, env =>
+            {
+                env["app.RequestStart"] = null;
+                return HelloApp(env);
+            }, null);
+            // Same hello world with all counters and sampled stage histograms recording, to see overhead of metrics
+            Run("alloc-get-metrics", GetRequest, iterations, HelloApp, new ServerMetrics());
+        }
+
+        static Task HelloApp(IDictionary<string, object> env)
+        {
+            var requestHeaders = (IDictionary<string, string[]>)env["owin.RequestHeaders"];
+            string[] accept;
+            if (!requestHeaders.TryGetValue("Accept", out accept) || (string)env["owin.RequestPath"] != "/hello")
+                throw new InvalidOperationException("Request was not parsed");
+            var responseHeaders = (IDictionary<string, string[]>)env["owin.ResponseHeaders"];
+            responseHeaders["Content-Type"] = TextPlain;
+            var responseBody = (Stream)env["owin.ResponseBody"];
+            responseBody.Write(HelloWorld, 0, HelloWorld.Length);
+            return CompletedTask;
+        }
+
+        static Func<IDictionary<string, object>, Task> EchoApp(byte[] buffer)
+        {
+            return async env =>
+            {
+                var requestBody = (Stream)env["owin.RequestBody"];
+                var len = await requestBody.ReadAsync(buffer, 0, buffer.Length);
+                var responseBody = (Stream)env["owin.ResponseBody"];
+                await responseBody.WriteAsync(buffer, 0, len);
+            };
+        }
+
+        static void Run(string name, string request, int iterations, Func<IDictionary<string, object>, Task> app, ServerMetrics metrics)
+        {
+            var factory = new Transport2HttpFactory(ReceiveBufferSize, false, "Nowin", new IpIsLocalChecker(), new OwinHandlerFactory(app, new Dictionary<string, object>()), metrics);
+            var buffer = new byte[factory.PerConnectionBufferSize + factory.CommonBufferSize];
+            factory.InitCommonBuffer(buffer, factory.PerConnectionBufferSize);
+            var handler = (ITransportLayerHandler)factory.Create(buffer, 0, factory.PerConnectionBufferSize, 0);
+            var callback = new InMemoryTransportCallback(handler);
+            handler.Callback = callback;
+            var requestBytes = Encoding.ASCII.GetBytes(request);
+            handler.PrepareAccept();
+            var endPoint = new IPEndPoint(IPAddress.Loopback, 8888);
+            handler.FinishAccept(buffer, callback.ReceiveOffset, 0, endPoint, endPoint);
+            Measure.Run(name, iterations, () =>
+            {
+                var offset = callback.ReceiveOffset;
+                Array.Copy(requestBytes, 0, buffer, offset, requestBytes.Length);
+                handler.FinishReceive(buffer, offset, requestBytes.Length);
+            });
+        }
+    }
+}
@@ -0,0 +1,49 @@
+using System;
+using System.Collections.Generic;
+using Nowin;
+
+namespace NowinBenchmark
+{
+    // Transport which completes every send immediately, request bytes are copied directly to receive buffer by benchmark
+    class InMemoryTransportCallback : ITransportLayerCallback
+    {
+        readonly ITransportLayerHandler _handler;
+
+        public InMemoryTransportCallback(ITransportLayerHandler handler)
+        {
+            _handler = handler;
+        }
+
+        public int ReceiveOffset { get; private set; }
+
+        public void StartAccept(byte[] buffer, int offset, int length)
+        {
+            ReceiveOffset = offset;
+        }
+
+        public void StartReceive(byte[] buffer, int offset, int length)
+        {
+            ReceiveOffset = offset;
+        }
+
+        public void StartSend(byte[] buffer, int offset, int length)
+        {
+            _handler.FinishSend(null);
+        }
+
+        public void StartSend(IList<ArraySegment<byte>> buffers)
+        {
+            _handler.FinishSend(null);
+        }
+
+        public void StartSendFile(IList<ArraySegment<byte>> head, string fileName, long offset, long count, ArraySegment<byte> tail)
+        {
+            _handler.FinishSend(null);
+        }
+
+        public void StartDisconnect()
+        {
+            throw new InvalidOperationException("Benchmark connection should stay alive");
+        }
+    }
+}
@@ -0,0 +1,120 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Nowin;
+
+namespace NowinBenchmark
+{
+    // Keep-alive clients downloading 1MB responses, compares one large stream write (gather send) with sendfile.SendAsync
+    static class LargeResponseBenchmark
+    {
+        const int Port = 8890;
+        const int ResponseSize = 1024 * 1024;
+        static readonly byte[] Request = Encoding.ASCII.GetBytes("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        static readonly byte[] HeadersEnd = Encoding.ASCII.GetBytes("\r\n\r\n");
+
+        public static void Run(int requests)
+        {
+            if (requests == 0) requests = 2000;
+            var content = new byte[ResponseSize];
+            new Random(1).NextBytes(content);
+            var fileName = Path.GetTempFileName();
+            try
+            {
+                File.WriteAllBytes(fileName, content);
+                Run("large-write", requests, env =>
+                {
+                    var responseStream = (Stream)env["owin.ResponseBody"];
+                    return responseStream.WriteAsync(content, 0, content.Length);
+                });
+                Run("large-sendfile", requests, env =>
+                {
+                    var sendFile = (Func<string, long, long?, CancellationToken, Task>)env["sendfile.SendAsync"];
+                    return sendFile(fileName, 0, null, CancellationToken.None);
+                });
+            }
+            finally
+            {
+                File.Delete(fileName);
+            }
+        }
+
+        static void Run(string name, int requests, Func<IDictionary<string, object>, Task> body)
+        {
+            using (ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env =>
+                {
+                    var responseHeaders = (IDictionary<string, string[]>)env["owin.ResponseHeaders"];
+                    responseHeaders["Content-Length"] = new[] { ResponseSize.ToString(CultureInfo.InvariantCulture) };
+                    return body(env);
+                })
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Start())
+            {
+                var clients = Environment.ProcessorCount;
+                var remaining = requests;
+                var allocatedBefore = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize;
+                var gen0 = GC.CollectionCount(0);
+                var sw = Stopwatch.StartNew();
+                var threads = new Thread[clients];
+                for (var i = 0; i < clients; i++)
+                {
+                    threads[i] = new Thread(() =>
+                    {
+                        using (var socket = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp))
+                        {
+                            socket.NoDelay = true;
+                            socket.Connect(IPAddress.Loopback, Port);
+                            var response = new byte[65536];
+                            while (Interlocked.Decrement(ref remaining) >= 0)
+                            {
+                                socket.Send(Request);
+                                ReceiveResponse(socket, response);
+                            }
+                        }
+                    });
+                    threads[i].Start();
+                }
+                foreach (var thread in threads) thread.Join();
+                sw.Stop();
+                var allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize - allocatedBefore;
+                Measure.Report(name, requests, sw.Elapsed.TotalMilliseconds * 1e6 / requests, (double)allocated / requests, GC.CollectionCount(0) - gen0);
+                Console.WriteLine("{0,-24} {1,10:F1} MB/s", name, (double)requests * ResponseSize / 1024 / 1024 / sw.Elapsed.TotalSeconds);
+            }
+        }
+
+        // Response has known Content-Length so it is enough to find end of headers and count remaining bytes
+        static void ReceiveResponse(Socket socket, byte[] buffer)
+        {
+            long remaining = -1;
+            var matched = 0;
+            while (remaining != 0)
+            {
+                var read = socket.Receive(buffer);
+                if (read == 0) throw new EndOfStreamException();
+                if (remaining > 0)
+                {
+                    remaining -= read;
+                    continue;
+                }
+                for (var i = 0; i < read; i++)
+                {
+                    matched = buffer[i] == HeadersEnd[matched] ? matched + 1 : (buffer[i] == '\r' ? 1 : 0);
+                    if (matched == 4)
+                    {
+                        remaining = ResponseSize - (read - i - 1);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,252 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Net;
+using System.Security.Authentication;
+using System.Security.Cryptography.X509Certificates;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+using Nowin;
+
+namespace NowinBenchmark
+{
+    using WebSocketAccept = Action<IDictionary<string, object>, Func<IDictionary<string, object>, Task>>;
+    using WebSocketSendAsync = Func<ArraySegment<byte>, int, bool, CancellationToken, Task>;
+    using WebSocketReceiveAsync = Func<ArraySegment<byte>, CancellationToken, Task<Tuple<int, bool, int>>>;
+    using WebSocketCloseAsync = Func<int, string, CancellationToken, Task>;
+
+    // In-process server driven by many blocking keep-alive connections, replaces ab/WeigHTTP runs.
+    // Latency of request is measured from sending it (or its pipelined batch) to reading whole response.
+    static class LoadBenchmark
+    {
+        const int Port = 8891;
+        const int Connections = 64;
+        const int LargeResponseSize = 256 * 1024;
+        const int PipelineDepth = 16;
+        const int WarmupPerConnection = 20;
+
+        static readonly byte[] HelloWorld = Encoding.ASCII.GetBytes("Hello World!");
+        static readonly string[] TextPlain = { "text/plain" };
+        static readonly string[] HelloWorldLength = { "12" };
+        static readonly string[] LargeLength = { LargeResponseSize.ToString() };
+        static readonly byte[] LargeBody = new byte[LargeResponseSize];
+        static readonly Task CompletedTask = Task.FromResult(0);
+
+        static readonly string GetRequest = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        static readonly string ChunkedPostRequest = "POST /echo HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n" +
+            "400\r\n" + new string('a', 1024) + "\r\n" +
+            "400\r\n" + new string('b', 1024) + "\r\n" +
+            "0\r\n\r\n";
+        static readonly string WebSocketHandshake = "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n" +
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+        // Masked text frame with 32 byte payload and zero mask key
+        static readonly byte[] WebSocketFrame = CreateMaskedFrame(0x81, 32);
+        static readonly byte[] WebSocketClose = CreateMaskedFrame(0x88, 0);
+
+        public static void Run(int requests)
+        {
+            if (requests == 0) requests = 100000;
+            Run("load-small", SmallApp, null, Connections, GetRequest, 1, requests);
+            // Same as load-small with counters and sampled stage histograms recording, difference is overhead of metrics
+            Run("load-small-metrics", SmallApp, null, Connections, GetRequest, 1, requests, true);
+            Run("load-chunked", ChunkedEchoApp, null, Connections, ChunkedPostRequest, 1, requests / 2);
+            Run("load-large", LargeApp, null, 16, GetRequest, 1, Math.Max(requests / 50, 100));
+            Run("load-pipelined", SmallApp, null, 16, GetRequest, PipelineDepth, requests);
+            var certificate = LoadCertificate();
+            if (certificate == null)
+                Console.WriteLine("{0,-24} skipped, sslcert/test.pfx not found", "load-tls");
+            else
+                Run("load-tls", SmallApp, certificate, Connections, GetRequest, 1, requests / 2);
+            Run("load-websocket", WebSocketApp, null, Connections, null, 1, requests);
+        }
+
+        static Task SmallApp(IDictionary<string, object> env)
+        {
+            var headers = (IDictionary<string, string[]>)env["owin.ResponseHeaders"];
+            headers["Content-Type"] = TextPlain;
+            headers["Content-Length"] = HelloWorldLength;
+            ((Stream)env["owin.ResponseBody"]).Write(HelloWorld, 0, HelloWorld.Length);
+            return CompletedTask;
+        }
+
+        static Task LargeApp(IDictionary<string, object> env)
+        {
+            var headers = (IDictionary<string, string[]>)env["owin.ResponseHeaders"];
+            headers["Content-Length"] = LargeLength;
+            return ((Stream)env["owin.ResponseBody"]).WriteAsync(LargeBody, 0, LargeBody.Length);
+        }
+
+        // Response without Content-Length is sent chunked
+        static async Task ChunkedEchoApp(IDictionary<string, object> env)
+        {
+            var requestBody = (Stream)env["owin.RequestBody"];
+            var responseBody = (Stream)env["owin.ResponseBody"];
+            var buffer = new byte[4096];
+            int read;
+            while ((read = await requestBody.ReadAsync(buffer, 0, buffer.Length)) > 0)
+            {
+                await responseBody.WriteAsync(buffer, 0, read);
+                await responseBody.FlushAsync();
+            }
+        }
+
+        static Task WebSocketApp(IDictionary<string, object> env)
+        {
+            var accept = (WebSocketAccept)env["websocket.Accept"];
+            accept(null, WebSocketEcho);
+            return CompletedTask;
+        }
+
+        static async Task WebSocketEcho(IDictionary<string, object> env)
+        {
+            var send = (WebSocketSendAsync)env["websocket.SendAsync"];
+            var receive = (WebSocketReceiveAsync)env["websocket.ReceiveAsync"];
+            var close = (WebSocketCloseAsync)env["websocket.CloseAsync"];
+            var buffer = new byte[4096];
+            while (true)
+            {
+                var result = await receive(new ArraySegment<byte>(buffer), CancellationToken.None);
+                if (result.Item1 == 8)
+                {
+                    await close(1000, "", CancellationToken.None);
+                    return;
+                }
+                await send(new ArraySegment<byte>(buffer, 0, result.Item3), result.Item1, result.Item2, CancellationToken.None);
+            }
+        }
+
+        // request == null means WebSocket echo of one frame per operation
+        static void Run(string name, Func<IDictionary<string, object>, Task> app, X509Certificate certificate, int connections, string request, int depth, int operations, bool metrics = false)
+        {
+            var properties = new Dictionary<string, object>();
+            OwinServerFactory.Initialize(properties);
+            var builder = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(app)
+                .SetOwinCapabilities((IDictionary<string, object>)properties[OwinKeys.ServerCapabilitiesKey])
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4));
+            // Same protocol as LoadConnection uses, older ones are refused by some OpenSSL builds and the handshake fails
+            if (certificate != null) builder.SetCertificate(certificate).SetProtocols(SslProtocols.Tls12);
+            if (metrics) builder.EnableMetrics();
+            var requestBatch = request == null ? WebSocketFrame : Repeat(Encoding.ASCII.GetBytes(request), depth);
+            var batchLength = requestBatch.Length / depth;
+            var latencies = new long[operations];
+            var taken = 0;
+            var failed = 0;
+            using (builder.Start())
+            using (var ready = new CountdownEvent(connections))
+            using (var start = new ManualResetEventSlim())
+            {
+                var threads = new Thread[connections];
+                for (var i = 0; i < connections; i++)
+                {
+                    threads[i] = new Thread(() =>
+                    {
+                        try
+                        {
+                            using (var connection = new LoadConnection(Port, certificate != null))
+                            {
+                                if (request == null)
+                                {
+                                    var handshake = Encoding.ASCII.GetBytes(WebSocketHandshake);
+                                    connection.Send(handshake, handshake.Length);
+                                    if (connection.ReadResponse() != 101) throw new InvalidDataException("WebSocket upgrade failed");
+                                }
+                                for (var j = 0; j < WarmupPerConnection; j++)
+                                {
+                                    connection.Send(requestBatch, batchLength);
+                                    Receive(connection, request);
+                                }
+                                ready.Signal();
+                                start.Wait();
+                                while (true)
+                                {
+                                    var first = Interlocked.Add(ref taken, depth) - depth;
+                                    if (first >= operations) break;
+                                    var batch = Math.Min(depth, operations - first);
+                                    var sendTimestamp = Stopwatch.GetTimestamp();
+                                    connection.Send(requestBatch, batch * batchLength);
+                                    for (var j = 0; j < batch; j++)
+                                    {
+                                        Receive(connection, request);
+                                        latencies[first + j] = Stopwatch.GetTimestamp() - sendTimestamp;
+                                    }
+                                }
+                                if (request == null)
+                                {
+                                    connection.Send(WebSocketClose, WebSocketClose.Length);
+                                    connection.ReadWebSocketFrame();
+                                }
+                            }
+                        }
+                        catch (Exception ex)
+                        {
+                            if (Interlocked.Increment(ref failed) == 1) Console.WriteLine("{0,-24} connection failed: {1}", name, ex.Message);
+                            if (!ready.IsSet) ready.Signal();
+                        }
+                    });
+                    threads[i].Start();
+                }
+                ready.Wait();
+                GC.Collect();
+                GC.WaitForPendingFinalizers();
+                var gen0 = GC.CollectionCount(0);
+                var allocatedBefore = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize;
+                var sw = Stopwatch.StartNew();
+                start.Set();
+                foreach (var thread in threads) thread.Join();
+                sw.Stop();
+                var allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize - allocatedBefore;
+                if (failed > 0)
+                {
+                    Console.WriteLine("{0,-24} failed on {1} connections", name, failed);
+                    return;
+                }
+                Measure.ReportLoad(name, sw.Elapsed, latencies, (double)allocated / operations, GC.CollectionCount(0) - gen0);
+            }
+        }
+
+        static void Receive(LoadConnection connection, string request)
+        {
+            if (request == null)
+            {
+                connection.ReadWebSocketFrame();
+                return;
+            }
+            var status = connection.ReadResponse();
+            if (status != 200) throw new InvalidDataException("Unexpected status " + status);
+        }
+
+        static byte[] Repeat(byte[] data, int count)
+        {
+            var result = new byte[data.Length * count];
+            for (var i = 0; i < count; i++) Array.Copy(data, 0, result, i * data.Length, data.Length);
+            return result;
+        }
+
+        static byte[] CreateMaskedFrame(byte opcode, int payloadLength)
+        {
+            // Zero mask key leaves payload unchanged
+            var frame = new byte[6 + payloadLength];
+            frame[0] = opcode;
+            frame[1] = (byte)(0x80 | payloadLength);
+            for (var i = 6; i < frame.Length; i++) frame[i] = (byte)'x';
+            return frame;
+        }
+
+        // Test certificate is in repository root, benchmark can be started from any bin directory below it
+        static X509Certificate LoadCertificate()
+        {
+            var directory = new DirectoryInfo(AppDomain.CurrentDomain.BaseDirectory);
+            while (directory != null)
+            {
+                var fileName = Path.Combine(directory.FullName, "sslcert", "test.pfx");
+                if (File.Exists(fileName)) return new X509Certificate2(fileName, "nowin");
+                directory = directory.Parent;
+            }
+            return null;
+        }
+    }
+}
@@ -0,0 +1,200 @@
+using System;
+using System.IO;
+using System.Net;
+using System.Net.Security;
+using System.Net.Sockets;
+using System.Security.Authentication;
+using System.Text;
+
+namespace NowinBenchmark
+{
+    // Blocking keep-alive HTTP/1.1 and WebSocket client. After connecting it does not allocate itself, but socket and
+    // SslStream calls on its threads do, so allocations measured in benchmark process are reported as process-wide.
+    sealed class LoadConnection : IDisposable
+    {
+        static readonly byte[] ContentLengthName = Encoding.ASCII.GetBytes("content-length:");
+        static readonly byte[] TransferEncodingName = Encoding.ASCII.GetBytes("transfer-encoding:");
+
+        readonly Stream _stream;
+        readonly byte[] _buffer = new byte[65536];
+        int _pos;
+        int _end;
+
+        public LoadConnection(int port, bool tls)
+        {
+            var socket = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp) { NoDelay = true };
+            socket.Connect(IPAddress.Loopback, port);
+            _stream = new NetworkStream(socket, true);
+            if (tls)
+            {
+                var ssl = new SslStream(_stream, false, (sender, certificate, chain, errors) => true);
+                ssl.AuthenticateAsClient("localhost", null, SslProtocols.Tls12, false);
+                _stream = ssl;
+            }
+        }
+
+        public void Send(byte[] data, int length)
+        {
+            _stream.Write(data, 0, length);
+        }
+
+        // Reads one whole response and returns its status code
+        public int ReadResponse()
+        {
+            var line = ReadLine();
+            if (line < 12 || _buffer[_pos + 8] != ' ') throw new InvalidDataException("Invalid status line");
+            var status = (_buffer[_pos + 9] - '0') * 100 + (_buffer[_pos + 10] - '0') * 10 + (_buffer[_pos + 11] - '0');
+            _pos += line;
+            long contentLength = 0;
+            var chunked = false;
+            while (true)
+            {
+                line = ReadLine();
+                if (line == 2)
+                {
+                    _pos += 2;
+                    break;
+                }
+                if (StartsWithIgnoreCase(ContentLengthName))
+                {
+                    contentLength = ParseDecimal(_pos + ContentLengthName.Length, _pos + line);
+                }
+                else if (StartsWithIgnoreCase(TransferEncodingName))
+                {
+                    chunked = true;
+                }
+                _pos += line;
+            }
+            if (status == 101 || status == 204 || status == 304) return status;
+            if (!chunked)
+            {
+                Skip(contentLength);
+                return status;
+            }
+            while (true)
+            {
+                line = ReadLine();
+                var chunkLength = ParseHex(_pos, _pos + line);
+                _pos += line;
+                if (chunkLength == 0)
+                {
+                    // no trailers expected, only final CRLF
+                    Skip(2);
+                    return status;
+                }
+                Skip(chunkLength + 2);
+            }
+        }
+
+        // Reads one unmasked frame sent by server and returns its payload length
+        public int ReadWebSocketFrame()
+        {
+            Ensure(2);
+            var length = (long)(_buffer[_pos + 1] & 0x7f);
+            _pos += 2;
+            if (length == 126)
+            {
+                Ensure(2);
+                length = (_buffer[_pos] << 8) + _buffer[_pos + 1];
+                _pos += 2;
+            }
+            else if (length == 127)
+            {
+                Ensure(8);
+                length = 0;
+                for (var i = 0; i < 8; i++) length = (length << 8) + _buffer[_pos + i];
+                _pos += 8;
+            }
+            Skip(length);
+            return (int)length;
+        }
+
+        // Returns length of line including CRLF, line starts at _pos
+        int ReadLine()
+        {
+            var searchFrom = _pos;
+            while (true)
+            {
+                var index = Array.IndexOf(_buffer, (byte)'\n', searchFrom, _end - searchFrom);
+                if (index >= 0) return index + 1 - _pos;
+                searchFrom = _end - _pos;
+                Fill();
+                searchFrom += _pos;
+            }
+        }
+
+        void Ensure(int count)
+        {
+            while (_end - _pos < count) Fill();
+        }
+
+        void Skip(long count)
+        {
+            while (true)
+            {
+                var available = _end - _pos;
+                if (available >= count)
+                {
+                    _pos += (int)count;
+                    return;
+                }
+                count -= available;
+                _pos = _end;
+                Fill();
+            }
+        }
+
+        void Fill()
+        {
+            if (_pos > 0)
+            {
+                Array.Copy(_buffer, _pos, _buffer, 0, _end - _pos);
+                _end -= _pos;
+                _pos = 0;
+            }
+            if (_end == _buffer.Length) throw new InvalidDataException("Response line too long");
+            var read = _stream.Read(_buffer, _end, _buffer.Length - _end);
+            if (read <= 0) throw new EndOfStreamException();
+            _end += read;
+        }
+
+        bool StartsWithIgnoreCase(byte[] lowerCaseName)
+        {
+            if (_end - _pos < lowerCaseName.Length) return false;
+            for (var i = 0; i < lowerCaseName.Length; i++)
+            {
+                if ((_buffer[_pos + i] | 0x20) != lowerCaseName[i]) return false;
+            }
+            return true;
+        }
+
+        long ParseDecimal(int start, int end)
+        {
+            long result = 0;
+            for (var i = start; i < end; i++)
+            {
+                var ch = _buffer[i];
+                if (ch >= '0' && ch <= '9') result = result * 10 + ch - '0';
+            }
+            return result;
+        }
+
+        long ParseHex(int start, int end)
+        {
+            long result = 0;
+            for (var i = start; i < end; i++)
+            {
+                var ch = _buffer[i] | 0x20;
+                if (ch >= '0' && ch <= '9') result = result * 16 + ch - '0';
+                else if (ch >= 'a' && ch <= 'f') result = result * 16 + ch - 'a' + 10;
+                else break;
+            }
+            return result;
+        }
+
+        public void Dispose()
+        {
+            _stream.Dispose();
+        }
+    }
+}
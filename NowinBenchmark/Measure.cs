@@ -0,0 +1,129 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+
+namespace NowinBenchmark
+{
+    static class Measure
+    {
+        static readonly List<Result> Results = new List<Result>();
+
+        class Result
+        {
+            public string Name;
+            public int Operations;
+            public double NsPerOp;
+            public double BytesPerOp;
+            public int Gen0Collections;
+            // Only for load benchmarks
+            public double OpsPerSecond;
+            public double P50Us;
+            public double P99Us;
+            public double P999Us;
+            // Load benchmarks run client threads in the same process, their allocations are included
+            public bool ProcessWideAllocations;
+        }
+
+        public static void Run(string name, int iterations, Action action)
+        {
+            // Warm up JIT and per connection caches
+            for (var i = 0; i < Math.Min(iterations, 1000); i++) action();
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+            var gen0 = GC.CollectionCount(0);
+            var allocatedBefore = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize;
+            var sw = Stopwatch.StartNew();
+            for (var i = 0; i < iterations; i++) action();
+            sw.Stop();
+            var allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize - allocatedBefore;
+            Report(name, iterations, sw.Elapsed.TotalMilliseconds * 1e6 / iterations, (double)allocated / iterations, GC.CollectionCount(0) - gen0);
+        }
+
+        public static void Report(string name, int iterations, double nsPerOp, double bytesPerOp, int gen0Collections)
+        {
+            Console.WriteLine("{0,-24} {1,10} ops {2,12:F1} ns/op {3,10:F1} B/op {4,6} gen0", name, iterations, nsPerOp, bytesPerOp, gen0Collections);
+            Results.Add(new Result { Name = name, Operations = iterations, NsPerOp = nsPerOp, BytesPerOp = bytesPerOp, Gen0Collections = gen0Collections });
+        }
+
+        // latencies are in Stopwatch ticks and are sorted in place
+        public static void ReportLoad(string name, TimeSpan elapsed, long[] latencies, double bytesPerOp, int gen0Collections)
+        {
+            Array.Sort(latencies);
+            var operations = latencies.Length;
+            Report(name, operations, elapsed.TotalMilliseconds * 1e6 / operations, bytesPerOp, gen0Collections);
+            var result = Results[Results.Count - 1];
+            result.ProcessWideAllocations = true;
+            result.OpsPerSecond = operations / elapsed.TotalSeconds;
+            result.P50Us = Percentile(latencies, 50);
+            result.P99Us = Percentile(latencies, 99);
+            result.P999Us = Percentile(latencies, 99.9);
+            Console.WriteLine("{0,-24} {1,10:F0} req/s {2,10:F1} p50 us {3,10:F1} p99 us {4,10:F1} p999 us (B/op is process-wide)", "", result.OpsPerSecond, result.P50Us, result.P99Us, result.P999Us);
+        }
+
+        static double Percentile(long[] sorted, double percentile)
+        {
+            var index = (int)Math.Ceiling(sorted.Length * percentile / 100) - 1;
+            return sorted[Math.Max(0, Math.Min(index, sorted.Length - 1))] * 1e6 / Stopwatch.Frequency;
+        }
+
+        // One JSON document per run, so results of different commits can be compared by tools
+        public static void WriteJson(string fileName)
+        {
+            using (var writer = new StreamWriter(fileName))
+            {
+                writer.Write("{\n  \"timestamp\": \"");
+                writer.Write(DateTime.UtcNow.ToString("o", CultureInfo.InvariantCulture));
+                writer.Write("\",\n  \"machine\": ");
+                WriteString(writer, Environment.MachineName);
+                writer.Write(",\n  \"os\": ");
+                WriteString(writer, Environment.OSVersion.ToString());
+                writer.Write(",\n  \"runtime\": ");
+                WriteString(writer, Environment.Version.ToString());
+                writer.Write(",\n  \"processorCount\": ");
+                writer.Write(Environment.ProcessorCount.ToString(CultureInfo.InvariantCulture));
+                writer.Write(",\n  \"results\": [");
+                for (var i = 0; i < Results.Count; i++)
+                {
+                    var result = Results[i];
+                    writer.Write(i == 0 ? "\n    { \"name\": " : ",\n    { \"name\": ");
+                    WriteString(writer, result.Name);
+                    WriteNumber(writer, "operations", result.Operations);
+                    WriteNumber(writer, "nsPerOp", result.NsPerOp);
+                    WriteNumber(writer, result.ProcessWideAllocations ? "processBytesPerOp" : "bytesPerOp", result.BytesPerOp);
+                    WriteNumber(writer, "gen0", result.Gen0Collections);
+                    if (result.OpsPerSecond > 0)
+                    {
+                        WriteNumber(writer, "opsPerSecond", result.OpsPerSecond);
+                        WriteNumber(writer, "p50Us", result.P50Us);
+                        WriteNumber(writer, "p99Us", result.P99Us);
+                        WriteNumber(writer, "p999Us", result.P999Us);
+                    }
+                    writer.Write(" }");
+                }
+                writer.Write("\n  ]\n}\n");
+            }
+        }
+
+        static void WriteNumber(TextWriter writer, string name, double value)
+        {
+            writer.Write(", \"");
+            writer.Write(name);
+            writer.Write("\": ");
+            writer.Write(Math.Round(value, 3).ToString(CultureInfo.InvariantCulture));
+        }
+
+        static void WriteString(TextWriter writer, string value)
+        {
+            writer.Write('"');
+            foreach (var ch in value)
+            {
+                if (ch == '"' || ch == '\\') writer.Write('\\');
+                if (ch < ' ') writer.Write("\\u{0:x4}", (int)ch);
+                else writer.Write(ch);
+            }
+            writer.Write('"');
+        }
+    }
+}
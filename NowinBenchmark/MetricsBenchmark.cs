@@ -0,0 +1,36 @@
+using Nowin;
+
+namespace NowinBenchmark
+{
+    // Counters and stage latencies recorded for one keep-alive request the same way Transport2HttpHandler does,
+    // compare with ns/op of alloc-get to get overhead of metrics
+    static class MetricsBenchmark
+    {
+        public static void Run(int iterations)
+        {
+            if (iterations == 0) iterations = 10000000;
+            Run("metrics-request", new ServerMetrics(), iterations);
+            Run("metrics-request-all", new ServerMetrics(1), iterations);
+        }
+
+        static void Run(string name, ServerMetrics metrics, int iterations)
+        {
+            var countdown = 1;
+            Measure.Run(name, iterations, () =>
+            {
+                metrics.Add(MetricsCounter.BytesReceived, 100);
+                var timed = metrics.SampleLatency(ref countdown);
+                var timestamp = timed ? metrics.RecordSince(MetricsStage.KeepAliveIdle, ServerMetrics.Timestamp()) : 0;
+                metrics.Increment(MetricsCounter.Requests);
+                if (timed)
+                {
+                    timestamp = metrics.RecordSince(MetricsStage.Parse, timestamp);
+                    timestamp = metrics.RecordSince(MetricsStage.App, timestamp);
+                }
+                metrics.RecordStatusCode(200);
+                if (timed) metrics.RecordSince(MetricsStage.Send, timestamp);
+                metrics.Add(MetricsCounter.BytesSent, 100);
+            });
+        }
+    }
+}
@@ -0,0 +1,49 @@
+using System;
+
+namespace NowinBenchmark
+{
+    static class Program
+    {
+        static int Main(string[] args)
+        {
+            AppDomain.MonitoringIsEnabled = true;
+            var benchmark = args.Length > 0 ? args[0] : "all";
+            // 0 means default count for given benchmark
+            var iterations = args.Length > 1 ? int.Parse(args[1]) : 0;
+            switch (benchmark)
+            {
+                case "parse":
+                    ParseBenchmark.Run(iterations);
+                    break;
+                case "accept":
+                    AcceptBenchmark.Run(iterations);
+                    break;
+                case "alloc":
+                    AllocationBenchmark.Run(iterations);
+                    break;
+                case "large":
+                    LargeResponseBenchmark.Run(iterations);
+                    break;
+                case "load":
+                    LoadBenchmark.Run(iterations);
+                    break;
+                case "metrics":
+                    MetricsBenchmark.Run(iterations);
+                    break;
+                case "all":
+                    ParseBenchmark.Run(iterations);
+                    AllocationBenchmark.Run(iterations);
+                    MetricsBenchmark.Run(iterations);
+                    AcceptBenchmark.Run(iterations);
+                    LargeResponseBenchmark.Run(iterations);
+                    LoadBenchmark.Run(iterations);
+                    break;
+                default:
+                    Console.WriteLine("Usage: NowinBenchmark [all|parse|alloc|metrics|accept|large|load] [iterations] [json-file]");
+                    return 1;
+            }
+            if (args.Length > 2) Measure.WriteJson(args[2]);
+            return 0;
+        }
+    }
+}
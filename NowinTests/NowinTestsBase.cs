@@ -103,6 +103,38 @@ public void EmptyAppAnd2Requests()
             }
         }
 
+        [Fact]
+        public void EnvironmentIsResetBetweenKeepAliveRequests()
+        {
+            var requests = 0;
+            var listener = CreateServerSync(env =>
+                {
+                    requests++;
+                    Assert.False(env.ContainsKey("custom.Key"));
+                    Assert.False(env.ContainsKey("server.User"));
+                    var headers = (IDictionary<string, string[]>)env["owin.RequestHeaders"];
+                    Assert.Equal("/" + requests, env["owin.RequestPath"]);
+                    Assert.Equal(new[] { requests.ToString() }, headers["X-Request"]);
+                    Assert.Equal(new[] { "same" }, headers["X-Same"]);
+                    headers["X-Same"][0] = "modified";
+                    env["custom.Key"] = requests;
+                    env["server.User"] = null;
+                });
+            using (listener)
+            {
+                var client = new HttpClient();
+                for (var i = 1; i <= 3; i++)
+                {
+                    var request = new HttpRequestMessage(HttpMethod.Get, HttpClientAddress + i);
+                    request.Headers.Add("X-Request", i.ToString());
+                    request.Headers.Add("X-Same", "same");
+                    var response = client.SendAsync(request).Result;
+                    Assert.Equal(HttpStatusCode.OK, response.StatusCode);
+                }
+                Assert.Equal(3, requests);
+            }
+        }
+
         [Fact]
         public void ThrowAppRespond500()
         {
@@ -1211,6 +1243,69 @@ public void LargeResponseBodyWithFlushAnd1WriteAsyncWorks()
             CheckLargeBody(app);
         }
 
+        [Fact]
+        public void LargeResponseBodyWithSmallWriteAnd1AsyncWriteWorks()
+        {
+            OwinApp app = async env =>
+            {
+                var responseStream = env.Get<Stream>("owin.ResponseBody");
+                var pos = 0;
+                var buffer = PrepareLargeResponseBuffer(ref pos, 1000);
+                await responseStream.WriteAsync(buffer, 0, buffer.Length);
+                buffer = PrepareLargeResponseBuffer(ref pos, 99000);
+                await responseStream.WriteAsync(buffer, 0, buffer.Length);
+            };
+            CheckLargeBody(app);
+        }
+
+        [Fact]
+        public void LargeResponseBodyWithSendFileWorks()
+        {
+            var fileName = Path.GetTempFileName();
+            try
+            {
+                var pos = 0;
+                File.WriteAllBytes(fileName, PrepareLargeResponseBuffer(ref pos, 100000));
+                OwinApp app = async env =>
+                {
+                    var responseStream = env.Get<Stream>("owin.ResponseBody");
+                    var filePos = 0;
+                    var buffer = PrepareLargeResponseBuffer(ref filePos, 1000);
+                    await responseStream.WriteAsync(buffer, 0, buffer.Length);
+                    var sendFile = env.Get<Func<string, long, long?, CancellationToken, Task>>("sendfile.SendAsync");
+                    await sendFile(fileName, 1000, null, CancellationToken.None);
+                };
+                CheckLargeBody(app);
+            }
+            finally
+            {
+                File.Delete(fileName);
+            }
+        }
+
+        [Fact]
+        public void LargeResponseBodyWithSendFileAndContentLengthWorks()
+        {
+            var fileName = Path.GetTempFileName();
+            try
+            {
+                var pos = 0;
+                File.WriteAllBytes(fileName, PrepareLargeResponseBuffer(ref pos, 100000));
+                OwinApp app = env =>
+                {
+                    var responseHeaders = env.Get<IDictionary<string, string[]>>("owin.ResponseHeaders");
+                    responseHeaders.Add("Content-Length", new[] { "100000" });
+                    var sendFile = env.Get<Func<string, long, long?, CancellationToken, Task>>("sendfile.SendAsync");
+                    return sendFile(fileName, 0, 100000, CancellationToken.None);
+                };
+                CheckLargeBody(app);
+            }
+            finally
+            {
+                File.Delete(fileName);
+            }
+        }
+
         static byte[] PrepareLargeResponseBuffer(ref int pos, int len)
         {
             var buffer = new byte[len];
@@ -1,6 +1,8 @@
 using System;
 using System.Collections.Generic;
+using System.IO;
 using System.Net;
+using System.Net.Http;
 using System.Threading.Tasks;
 using Nowin;
 using Xunit;
@@ -97,5 +99,737 @@ public void ClosingClientConnectionDoesCancelSyncServer()
                 Assert.True(callCancelled);
             }
         }
+
+        [Fact]
+        public void HeaderValuesAreNotReusedFromPreviousRequestOnSameConnection()
+        {
+            var cookies = new List<string>();
+            var accepts = new List<string>();
+            using (CreateServer(
+                env =>
+                {
+                    var headers = (IDictionary<string, string[]>)env["owin.RequestHeaders"];
+                    cookies.Add(headers["Cookie"][0]);
+                    accepts.Add(headers["Accept"][0]);
+                    return Task.Delay(0);
+                }))
+            {
+                using (var client = new TcpClient())
+                {
+                    client.Connect(new IPEndPoint(IPAddress.Parse("127.0.0.1"), Port));
+                    using (var connStream = client.GetStream())
+                    {
+                        foreach (var request in new[]
+                        {
+                            "GET / HTTP/1.1\r\nHost: localhost:8082\r\nCookie: a=1\r\nAccept: */*\r\n\r\n",
+                            "GET / HTTP/1.1\r\nhost: localhost:8082\r\ncookie: a=2\r\naccept: text/plain\r\n\r\n",
+                            "GET / HTTP/1.1\r\nHost: localhost:8082\r\nCookie: a=2\r\nAccept: */*\r\n\r\n"
+                        })
+                        {
+                            var requestBytes = Encoding.ASCII.GetBytes(request);
+                            connStream.Write(requestBytes, 0, requestBytes.Length);
+                            var response = new StringBuilder();
+                            var buffer = new byte[1024];
+                            while (!response.ToString().EndsWith("\r\n\r\n"))
+                            {
+                                var read = connStream.Read(buffer, 0, buffer.Length);
+                                Assert.True(read > 0);
+                                response.Append(Encoding.ASCII.GetString(buffer, 0, read));
+                            }
+                            Assert.StartsWith("HTTP/1.1 200", response.ToString());
+                        }
+                    }
+                }
+            }
+            Assert.Equal(new[] { "a=1", "a=2", "a=2" }, cookies);
+            Assert.Equal(new[] { "*/*", "text/plain", "*/*" }, accepts);
+        }
+
+        static string ReadResponseHead(NetworkStream stream)
+        {
+            var response = new StringBuilder();
+            var buffer = new byte[1024];
+            while (!response.ToString().Contains("\r\n\r\n"))
+            {
+                var read = stream.Read(buffer, 0, buffer.Length);
+                if (read == 0) break;
+                response.Append(Encoding.ASCII.GetString(buffer, 0, read));
+            }
+            return response.ToString();
+        }
+
+        [Fact]
+        public void RequestHeadSplitIntoSingleBytesIsParsed()
+        {
+            var paths = new List<string>();
+            using (CreateServer(env =>
+                {
+                    paths.Add((string)env["owin.RequestPath"]);
+                    return Task.Delay(0);
+                }))
+            {
+                using (var client = new TcpClient())
+                {
+                    client.NoDelay = true;
+                    client.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    var stream = client.GetStream();
+                    stream.ReadTimeout = 10000;
+                    // Terminator straddles receives too
+                    var request = Encoding.ASCII.GetBytes("GET /split/head HTTP/1.1\r\nHost: localhost\r\n\r\n");
+                    for (var i = 0; i < request.Length; i++)
+                    {
+                        stream.Write(request, i, 1);
+                        Thread.Sleep(1);
+                    }
+                    Assert.StartsWith("HTTP/1.1 200", ReadResponseHead(stream));
+                }
+            }
+            Assert.Equal(new[] { "/split/head" }, paths);
+        }
+
+        [Theory]
+        [InlineData(0, "HTTP/1.1 200")]
+        [InlineData(1, "HTTP/1.1 400")]
+        public void RequestHeadEndingExactlyAtReceiveBufferEnd(int overflow, string expectedStatus)
+        {
+            const int bufferSize = 2048;
+            using (ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env => Task.Delay(0))
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(1, 0, 1, 0))
+                .SetBufferSize(bufferSize)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Start())
+            {
+                using (var client = new TcpClient())
+                {
+                    client.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    var stream = client.GetStream();
+                    stream.ReadTimeout = 10000;
+                    const string start = "GET / HTTP/1.1\r\nHost: localhost\r\nX-Pad: ";
+                    var head = start + new string('p', bufferSize - start.Length - 4 + overflow) + "\r\n\r\n";
+                    var request = Encoding.ASCII.GetBytes(head);
+                    Assert.Equal(bufferSize + overflow, request.Length);
+                    stream.Write(request, 0, request.Length);
+                    Assert.StartsWith(expectedStatus, ReadResponseHead(stream));
+                }
+            }
+        }
+
+        [Fact]
+        public void FlushedChunksAreNotDelayedByNagle()
+        {
+            const int requests = 20;
+            var chunk = Encoding.ASCII.GetBytes("chunk");
+            using (CreateServer(async env =>
+                {
+                    var body = (Stream)env["owin.ResponseBody"];
+                    await body.WriteAsync(chunk, 0, chunk.Length);
+                    await body.FlushAsync();
+                    await body.WriteAsync(chunk, 0, chunk.Length);
+                }))
+            {
+                using (var client = new TcpClient())
+                {
+                    client.NoDelay = true;
+                    client.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    var stream = client.GetStream();
+                    stream.ReadTimeout = 10000;
+                    var request = Encoding.ASCII.GetBytes("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+                    var buffer = new byte[1024];
+                    var sw = new System.Diagnostics.Stopwatch();
+                    // First request only warms up
+                    for (var i = 0; i <= requests; i++)
+                    {
+                        if (i == 1) sw.Start();
+                        stream.Write(request, 0, request.Length);
+                        var response = new StringBuilder();
+                        while (!response.ToString().EndsWith("\r\n0\r\n\r\n"))
+                        {
+                            var read = stream.Read(buffer, 0, buffer.Length);
+                            Assert.True(read > 0);
+                            response.Append(Encoding.ASCII.GetString(buffer, 0, read));
+                        }
+                    }
+                    // Last segment of each response waiting for delayed ACK would take at least 40ms
+                    Assert.True(sw.ElapsedMilliseconds < requests * 20, sw.ElapsedMilliseconds + "ms");
+                }
+            }
+        }
+
+        [Fact]
+        public void ShardedListenersAcceptAllConnections()
+        {
+            var requests = 0;
+            using (ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env =>
+                {
+                    Interlocked.Increment(ref requests);
+                    return Task.Delay(0);
+                })
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(4, 0, 4, 0))
+                .SetListenerShards(4)
+                .SetListenBacklog(16)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Start())
+            {
+                for (var i = 0; i < 20; i++)
+                {
+                    using (var client = new TcpClient())
+                    {
+                        client.Connect(new IPEndPoint(IPAddress.Parse("127.0.0.1"), Port));
+                        using (var connStream = client.GetStream())
+                        {
+                            var request = Encoding.UTF8.GetBytes("GET / HTTP/1.1\r\n"
+                                                                 + "Host: localhost:8082\r\n"
+                                                                 + "Connection: close\r\n"
+                                                                 + "\r\n");
+                            connStream.Write(request, 0, request.Length);
+                            var buffer = new byte[1024];
+                            var response = new StringBuilder();
+                            int read;
+                            while ((read = connStream.Read(buffer, 0, buffer.Length)) > 0)
+                            {
+                                response.Append(Encoding.ASCII.GetString(buffer, 0, read));
+                            }
+                            Assert.StartsWith("HTTP/1.1 200", response.ToString());
+                        }
+                    }
+                }
+            }
+            Assert.Equal(20, requests);
+        }
+
+        [Fact]
+        public void ListenerShardsDoNotExceedMaximumConnectionCount()
+        {
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env => Task.Delay(0))
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(2, 0, 2, 0))
+                .SetListenerShards(4)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                Assert.Equal(2, server.CurrentMaxConnectionCount);
+                var client = new HttpClient();
+                for (var i = 0; i < 4; i++)
+                {
+                    Assert.Equal(HttpStatusCode.OK, client.GetAsync("http://localhost:8082/").Result.StatusCode);
+                }
+            }
+        }
+
+        [Fact]
+        public void UnevenListenerShardsDoNotGrowOverMaximumConnectionCount()
+        {
+            var strategy = new ConnectionAllocationStrategy(4, 100, 1000, 40);
+            // Shards 400/200/200/200, smaller shard alone looks like 800 of 1000
+            Assert.Equal(0, Server.ShardNewConnectionCount(strategy, 4, 1000, 200, 195));
+            // Shards 400/200/200/190, growth step of 25 is clamped to what is left
+            Assert.Equal(10, Server.ShardNewConnectionCount(strategy, 4, 990, 190, 185));
+            Assert.Equal(25, Server.ShardNewConnectionCount(strategy, 4, 800, 200, 195));
+            Assert.Equal(0, Server.ShardNewConnectionCount(strategy, 4, 800, 200, 180));
+        }
+
+        [Fact]
+        public void IdleConnectionBlockIsReleased()
+        {
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env => Task.Delay(0))
+                .SetConnectionAllocationStrategy(new ElasticConnectionAllocationStrategy(3, 2, 10, 1, TimeSpan.FromMilliseconds(200)))
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                Assert.Equal(3, server.CurrentMaxConnectionCount);
+                var clients = new List<TcpClient>();
+                for (var i = 0; i < 3; i++)
+                {
+                    var client = new TcpClient();
+                    client.Connect(new IPEndPoint(IPAddress.Parse("127.0.0.1"), Port));
+                    clients.Add(client);
+                }
+                Assert.True(WaitFor(() => server.CurrentMaxConnectionCount == 5));
+                foreach (var client in clients) client.Close();
+                Assert.True(WaitFor(() => ((INowinServerMetrics)server).RetiredConnectionCount > 0 || server.CurrentMaxConnectionCount == 3));
+                // Waiting accepts which could not be cancelled are released after they serve their next connection
+                for (var i = 0; i < 50 && server.CurrentMaxConnectionCount > 3; i++)
+                {
+                    using (var client = new TcpClient())
+                    {
+                        client.Connect(new IPEndPoint(IPAddress.Parse("127.0.0.1"), Port));
+                        using (var connStream = client.GetStream())
+                        {
+                            var request = Encoding.UTF8.GetBytes("GET / HTTP/1.1\r\nHost: localhost:8082\r\nConnection: close\r\n\r\n");
+                            connStream.Write(request, 0, request.Length);
+                            var buffer = new byte[1024];
+                            while (connStream.Read(buffer, 0, buffer.Length) > 0)
+                            {
+                            }
+                        }
+                    }
+                    WaitFor(() => server.ConnectionCount == 0);
+                }
+                Assert.Equal(3, server.CurrentMaxConnectionCount);
+                Assert.Equal(0, ((INowinServerMetrics)server).RetiredConnectionCount);
+            }
+        }
+
+        [Fact]
+        public void MetricsCountRequestsAndAreServedOnEndpoint()
+        {
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env =>
+                {
+                    if ((string)env["owin.RequestPath"] == "/missing") env["owin.ResponseStatusCode"] = 404;
+                    return Task.Delay(0);
+                })
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(1, 0, 1, 0))
+                .SetMetricsEndpoint("/metrics")
+                .SetMetricsLatencySampleInterval(1)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                var client = new HttpClient();
+                Assert.Equal(HttpStatusCode.OK, client.GetAsync("http://localhost:8082/").Result.StatusCode);
+                Assert.Equal(HttpStatusCode.NotFound, client.GetAsync("http://localhost:8082/missing").Result.StatusCode);
+                var text = client.GetStringAsync("http://localhost:8082/metrics").Result;
+                Assert.Contains("nowin_responses_2xx_total 1\n", text);
+                Assert.Contains("nowin_responses_4xx_total 1\n", text);
+                Assert.Contains("nowin_stage_duration_seconds_count{stage=\"app\"} 2\n", text);
+                var metrics = ((INowinServerMetrics)server).Metrics;
+                Assert.True(WaitFor(() => metrics.GetCounter(MetricsCounter.Status2xx) == 2));
+                Assert.Equal(3, metrics.GetCounter(MetricsCounter.Requests));
+                Assert.Equal(1, metrics.GetCounter(MetricsCounter.ConnectionsAccepted));
+                Assert.True(metrics.GetCounter(MetricsCounter.BytesReceived) > 0);
+                Assert.True(metrics.GetCounter(MetricsCounter.BytesSent) > 0);
+                Assert.Equal(3, metrics.GetLatency(MetricsStage.App).Count);
+                Assert.Equal(2, metrics.GetLatency(MetricsStage.KeepAliveIdle).Count);
+                Assert.Equal(1, metrics.GetLatency(MetricsStage.RequestHead).Count);
+            }
+        }
+
+        [Fact]
+        public void MetricsMeasureStageLatenciesOnlyOfSampledRequests()
+        {
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env => Task.Delay(0))
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(1, 0, 1, 0))
+                .EnableMetrics()
+                .SetMetricsLatencySampleInterval(2)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                var client = new HttpClient();
+                for (var i = 0; i < 5; i++)
+                    Assert.Equal(HttpStatusCode.OK, client.GetAsync("http://localhost:8082/").Result.StatusCode);
+                var metrics = ((INowinServerMetrics)server).Metrics;
+                Assert.True(WaitFor(() => metrics.GetCounter(MetricsCounter.Status2xx) == 5));
+                Assert.Equal(5, metrics.GetCounter(MetricsCounter.Requests));
+                Assert.Equal(3, metrics.GetLatency(MetricsStage.App).Count);
+            }
+        }
+
+        [Fact]
+        public void ConnectionTimeoutsAreOffByDefault()
+        {
+            var timeouts = ((IServerParameters)ServerBuilder.New()).ConnectionTimeouts;
+            Assert.Equal(TimeSpan.Zero, timeouts.KeepAlive);
+            Assert.Equal(TimeSpan.Zero, timeouts.RequestHead);
+            Assert.Equal(0, timeouts.MinRequestBodyDataRate);
+        }
+
+        [Fact]
+        public void SlowRequestHeadIsDisconnectedAndConnectionIsReused()
+        {
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env => Task.Delay(0))
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(1, 0, 1, 0))
+                .SetRequestHeadTimeout(TimeSpan.FromSeconds(1))
+                .EnableMetrics()
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                using (var client = new TcpClient())
+                {
+                    client.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    var stream = client.GetStream();
+                    stream.ReadTimeout = 10000;
+                    var partialHead = Encoding.ASCII.GetBytes("GET / HTTP/1.1\r\nHost: localhost\r\n");
+                    stream.Write(partialHead, 0, partialHead.Length);
+                    Assert.Equal(0, stream.Read(new byte[1024], 0, 1024));
+                }
+                Assert.Equal(1, ((INowinServerMetrics)server).Metrics.GetCounter(MetricsCounter.ConnectionTimeouts));
+                // Only connection slot was recycled
+                Assert.True(WaitFor(() => server.ConnectionCount == 0));
+                var response = new HttpClient().GetAsync(HttpClientAddress).Result;
+                Assert.Equal(HttpStatusCode.OK, response.StatusCode);
+            }
+        }
+
+        [Fact]
+        public void IdleKeepAliveConnectionIsClosed()
+        {
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env => Task.Delay(0))
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(1, 0, 1, 0))
+                .SetKeepAliveTimeout(TimeSpan.FromSeconds(1))
+                .EnableMetrics()
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                using (var client = new TcpClient())
+                {
+                    client.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    var stream = client.GetStream();
+                    stream.ReadTimeout = 10000;
+                    var request = Encoding.ASCII.GetBytes("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+                    stream.Write(request, 0, request.Length);
+                    var response = new StringBuilder();
+                    var buffer = new byte[1024];
+                    while (!response.ToString().EndsWith("\r\n\r\n"))
+                    {
+                        var read = stream.Read(buffer, 0, buffer.Length);
+                        Assert.True(read > 0);
+                        response.Append(Encoding.ASCII.GetString(buffer, 0, read));
+                    }
+                    Assert.StartsWith("HTTP/1.1 200", response.ToString());
+                    Assert.Equal(0, stream.Read(buffer, 0, buffer.Length));
+                }
+                Assert.Equal(1, ((INowinServerMetrics)server).Metrics.GetCounter(MetricsCounter.ConnectionTimeouts));
+                Assert.True(WaitFor(() => server.ConnectionCount == 0));
+            }
+        }
+
+        [Fact]
+        public void SlowRequestBodyGetsRequestTimeout()
+        {
+            var bodyReadFinished = false;
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(async env =>
+                {
+                    var body = (Stream)env["owin.RequestBody"];
+                    var buffer = new byte[1024];
+                    try
+                    {
+                        while (await body.ReadAsync(buffer, 0, buffer.Length) > 0)
+                        {
+                        }
+                    }
+                    finally
+                    {
+                        bodyReadFinished = true;
+                    }
+                })
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(1, 0, 1, 0))
+                .SetMinRequestBodyDataRate(1000, TimeSpan.FromSeconds(1))
+                .EnableMetrics()
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                using (var client = new TcpClient())
+                {
+                    client.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    var stream = client.GetStream();
+                    stream.ReadTimeout = 10000;
+                    var request = Encoding.ASCII.GetBytes("POST / HTTP/1.1\r\nHost: localhost\r\nContent-Length: 100000\r\n\r\n0123456789");
+                    stream.Write(request, 0, request.Length);
+                    var buffer = new byte[1024];
+                    var read = stream.Read(buffer, 0, buffer.Length);
+                    Assert.StartsWith("HTTP/1.1 408", Encoding.ASCII.GetString(buffer, 0, read));
+                }
+                Assert.True(bodyReadFinished);
+                Assert.Equal(1, ((INowinServerMetrics)server).Metrics.GetCounter(MetricsCounter.ConnectionTimeouts));
+                Assert.True(WaitFor(() => server.ConnectionCount == 0));
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheServesRepeatedGetWithoutCallingApp()
+        {
+            var appCalls = 0;
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(env =>
+                {
+                    Interlocked.Increment(ref appCalls);
+                    var headers = (IDictionary<string, string[]>)env["owin.ResponseHeaders"];
+                    headers["Cache-Control"] = new[] { "public, max-age=60" };
+                    headers["Content-Type"] = new[] { "application/json" };
+                    var body = Encoding.UTF8.GetBytes("{\"cached\":true}");
+                    return ((System.IO.Stream)env["owin.ResponseBody"]).WriteAsync(body, 0, body.Length);
+                })
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(1, 0, 1, 0))
+                .EnableResponseCache(1024 * 1024, 64 * 1024)
+                .EnableMetrics()
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                var client = new HttpClient();
+                Assert.Equal("{\"cached\":true}", client.GetStringAsync(HttpClientAddress + "data?a=1").Result);
+                var response = client.GetAsync(HttpClientAddress + "data?a=1").Result;
+                Assert.Equal(HttpStatusCode.OK, response.StatusCode);
+                Assert.Equal("{\"cached\":true}", response.Content.ReadAsStringAsync().Result);
+                Assert.NotNull(response.Headers.Date);
+                Assert.Equal("application/json", response.Content.Headers.ContentType.MediaType);
+                Assert.Equal(1, appCalls);
+                // Different query is different resource
+                client.GetStringAsync(HttpClientAddress + "data?a=2").Wait();
+                Assert.Equal(2, appCalls);
+                Assert.Equal(1, ((INowinServerMetrics)server).Metrics.GetCounter(MetricsCounter.ResponseCacheHits));
+                Assert.Equal(2, ((INowinServerMetrics)server).Metrics.GetCounter(MetricsCounter.ResponseCacheMisses));
+            }
+        }
+
+        IDisposable CreateCachingServer(Func<IDictionary<string, object>, Task> app, long cacheSize = 1024 * 1024, int connections = 1, bool cacheRequestsWithCookies = false)
+        {
+            return ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(app)
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(connections, 0, connections, 0))
+                .EnableResponseCache(cacheSize, (int)Math.Min(cacheSize, 64 * 1024), cacheRequestsWithCookies)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Start();
+        }
+
+        static Task WriteCacheableResponse(IDictionary<string, object> env, string maxAge, string body)
+        {
+            var headers = (IDictionary<string, string[]>)env["owin.ResponseHeaders"];
+            headers["Cache-Control"] = new[] { "public, max-age=" + maxAge };
+            var bytes = Encoding.UTF8.GetBytes(body);
+            return ((Stream)env["owin.ResponseBody"]).WriteAsync(bytes, 0, bytes.Length);
+        }
+
+        [Theory]
+        [InlineData(false, 2)]
+        [InlineData(true, 1)]
+        public void ResponseCacheServesRequestsWithCookieOnlyWhenEnabled(bool cacheRequestsWithCookies, int expectedAppCalls)
+        {
+            var appCalls = 0;
+            using (CreateCachingServer(env =>
+                {
+                    Interlocked.Increment(ref appCalls);
+                    return WriteCacheableResponse(env, "60", "body");
+                }, cacheRequestsWithCookies: cacheRequestsWithCookies))
+            {
+                var client = new HttpClient();
+                for (var i = 0; i < 2; i++)
+                {
+                    var request = new HttpRequestMessage(HttpMethod.Get, HttpClientAddress);
+                    request.Headers.Add("Cookie", "session=" + i);
+                    Assert.Equal("body", client.SendAsync(request).Result.Content.ReadAsStringAsync().Result);
+                }
+                Assert.Equal(expectedAppCalls, appCalls);
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheKeepsVariantForEachVaryHeaderValue()
+        {
+            var appCalls = 0;
+            using (CreateCachingServer(env =>
+                {
+                    Interlocked.Increment(ref appCalls);
+                    var language = ((IDictionary<string, string[]>)env["owin.RequestHeaders"])["Accept-Language"][0];
+                    ((IDictionary<string, string[]>)env["owin.ResponseHeaders"])["Vary"] = new[] { "Accept-Language" };
+                    return WriteCacheableResponse(env, "60", language);
+                }))
+            {
+                var client = new HttpClient();
+                foreach (var language in new[] { "en", "de", "en", "de" })
+                {
+                    var request = new HttpRequestMessage(HttpMethod.Get, HttpClientAddress);
+                    request.Headers.Add("Accept-Language", language);
+                    var response = client.SendAsync(request).Result;
+                    Assert.Equal(language, response.Content.ReadAsStringAsync().Result);
+                }
+                Assert.Equal(2, appCalls);
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheKeepsHostsSeparate()
+        {
+            var appCalls = 0;
+            using (CreateCachingServer(env =>
+                {
+                    Interlocked.Increment(ref appCalls);
+                    var host = ((IDictionary<string, string[]>)env["owin.RequestHeaders"])["Host"][0];
+                    return WriteCacheableResponse(env, "60", host);
+                }, connections: 2))
+            {
+                var client = new HttpClient();
+                Assert.Equal("localhost:8082", client.GetStringAsync("http://localhost:8082/").Result);
+                Assert.Equal("127.0.0.1:8082", client.GetStringAsync("http://127.0.0.1:8082/").Result);
+                Assert.Equal("localhost:8082", client.GetStringAsync("http://localhost:8082/").Result);
+                Assert.Equal(2, appCalls);
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheEntryExpiresAfterMaxAge()
+        {
+            var appCalls = 0;
+            using (CreateCachingServer(env => WriteCacheableResponse(env, "1", Interlocked.Increment(ref appCalls).ToString())))
+            {
+                var client = new HttpClient();
+                Assert.Equal("1", client.GetStringAsync(HttpClientAddress).Result);
+                Assert.Equal("1", client.GetStringAsync(HttpClientAddress).Result);
+                Thread.Sleep(1100);
+                Assert.Equal("2", client.GetStringAsync(HttpClientAddress).Result);
+                Assert.Equal(2, appCalls);
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheEvictsLeastRecentlyUsed()
+        {
+            var appCalls = new List<string>();
+            // Each entry takes little more than 1000 bytes, so only two fit
+            using (CreateCachingServer(env =>
+                {
+                    lock (appCalls) appCalls.Add((string)env["owin.RequestPath"]);
+                    return WriteCacheableResponse(env, "60", new string('x', 900));
+                }, 3000))
+            {
+                var client = new HttpClient();
+                foreach (var path in new[] { "a", "b", "a", "c", "a", "b" })
+                {
+                    client.GetStringAsync(HttpClientAddress + path).Wait();
+                }
+                Assert.Equal(new[] { "/a", "/b", "/c", "/b" }, appCalls);
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheDoesNotStoreHeaderOutsideLatin1()
+        {
+            var appCalls = 0;
+            using (CreateCachingServer(env =>
+                {
+                    Interlocked.Increment(ref appCalls);
+                    ((IDictionary<string, string[]>)env["owin.ResponseHeaders"])["X-Name"] = new[] { "\u017Elu\u0165ou\u010Dk\u00FD" };
+                    return WriteCacheableResponse(env, "60", "body");
+                }))
+            {
+                var client = new HttpClient();
+                client.GetStringAsync(HttpClientAddress).Wait();
+                client.GetStringAsync(HttpClientAddress).Wait();
+                Assert.Equal(2, appCalls);
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheCallsAppOnceForConcurrentRequests()
+        {
+            var appCalls = 0;
+            using (CreateCachingServer(async env =>
+                {
+                    Interlocked.Increment(ref appCalls);
+                    await Task.Delay(300);
+                    await WriteCacheableResponse(env, "60", "slow");
+                }, connections: 8))
+            {
+                var responses = new List<Task<string>>();
+                for (var i = 0; i < 5; i++)
+                {
+                    responses.Add(new HttpClient().GetStringAsync(HttpClientAddress));
+                }
+                foreach (var response in responses)
+                {
+                    Assert.Equal("slow", response.Result);
+                }
+                Assert.Equal(1, appCalls);
+            }
+        }
+
+        [Fact]
+        public void ResponseCacheWaitOfDisconnectedClientDoesNotOutliveItsConnection()
+        {
+            var release = new TaskCompletionSource<object>();
+            var appCalls = 0;
+            using (var server = ServerBuilder.New()
+                .SetEndPoint(new IPEndPoint(IPAddress.Loopback, Port))
+                .SetOwinApp(async env =>
+                {
+                    Interlocked.Increment(ref appCalls);
+                    if ((string)env["owin.RequestPath"] == "/other")
+                    {
+                        await WriteCacheableResponse(env, "0", "other");
+                        return;
+                    }
+                    await release.Task;
+                    await WriteCacheableResponse(env, "60", "filled");
+                })
+                .SetConnectionAllocationStrategy(new ConnectionAllocationStrategy(2, 0, 2, 0))
+                .EnableResponseCache(1024 * 1024, 64 * 1024)
+                .SetRetrySocketBindingTime(TimeSpan.FromSeconds(4))
+                .Build())
+            {
+                server.Start();
+                var filling = new HttpClient().GetStringAsync(HttpClientAddress);
+                Assert.True(WaitFor(() => appCalls == 1));
+                var request = Encoding.ASCII.GetBytes("GET / HTTP/1.1\r\nHost: localhost:8082\r\n\r\n");
+                using (var waiting = new TcpClient())
+                {
+                    waiting.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    waiting.GetStream().Write(request, 0, request.Length);
+                    Assert.True(WaitFor(() => server.ConnectionCount == 2));
+                    Thread.Sleep(100);
+                }
+                // Slot of waiting request is free before fill ends
+                Assert.True(WaitFor(() => server.ConnectionCount == 1));
+                using (var next = new TcpClient())
+                {
+                    next.Connect(new IPEndPoint(IPAddress.Loopback, Port));
+                    var stream = next.GetStream();
+                    stream.ReadTimeout = 10000;
+                    Assert.True(WaitFor(() => server.ConnectionCount == 2));
+                    release.SetResult(null);
+                    Assert.Equal("filled", filling.Result);
+                    // Nothing may be sent on recycled slot before its own request
+                    Thread.Sleep(100);
+                    Assert.Equal(0, next.Available);
+                    var other = Encoding.ASCII.GetBytes("GET /other HTTP/1.1\r\nHost: localhost:8082\r\n\r\n");
+                    stream.Write(other, 0, other.Length);
+                    var response = new StringBuilder();
+                    var buffer = new byte[1024];
+                    while (!response.ToString().EndsWith("other"))
+                    {
+                        var read = stream.Read(buffer, 0, buffer.Length);
+                        Assert.True(read > 0);
+                        response.Append(Encoding.ASCII.GetString(buffer, 0, read));
+                    }
+                    Assert.StartsWith("HTTP/1.1 200", response.ToString());
+                }
+                Assert.Equal(2, appCalls);
+            }
+        }
+
+        static bool WaitFor(Func<bool> condition)
+        {
+            var until = DateTime.UtcNow + TimeSpan.FromSeconds(5);
+            while (!condition())
+            {
+                if (DateTime.UtcNow > until) return false;
+                Thread.Sleep(10);
+            }
+            return true;
+        }
     }
 }
\ No newline at end of file
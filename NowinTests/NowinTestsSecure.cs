@@ -1,9 +1,15 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.IO;
 using System.Net;
+using System.Net.Security;
+using System.Net.Sockets;
+using System.Security.Authentication;
 using System.Security.Cryptography.X509Certificates;
+using System.Text;
 using System.Threading.Tasks;
 using Nowin;
+using Xunit;
 
 // Heavily inspired by Katana project OwinHttpListener tests
 
@@ -40,5 +46,32 @@ protected override IDisposable CreateServer(Func<IDictionary<string, object>, Ta
                 .Start();
             return server;
         }
+
+        // Newer SslStream waits for incoming data with zero byte read of transport stream
+        [Fact]
+        public void RequestOverSslStreamIsServed()
+        {
+            using (CreateServer(env => Task.Delay(0)))
+            using (var client = new TcpClient())
+            {
+                client.Connect(new IPEndPoint(IPAddress.Loopback, 8082));
+                using (var ssl = new SslStream(client.GetStream(), false, delegate { return true; }))
+                {
+                    ssl.ReadTimeout = 10000;
+                    ssl.AuthenticateAsClient("localhost", null, SslProtocols.Tls12, false);
+                    var request = Encoding.ASCII.GetBytes("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+                    ssl.Write(request, 0, request.Length);
+                    var response = new StringBuilder();
+                    var buffer = new byte[1024];
+                    while (!response.ToString().Contains("\r\n\r\n"))
+                    {
+                        var read = ssl.Read(buffer, 0, buffer.Length);
+                        Assert.True(read > 0);
+                        response.Append(Encoding.ASCII.GetString(buffer, 0, read));
+                    }
+                    Assert.StartsWith("HTTP/1.1 200", response.ToString());
+                }
+            }
+        }
     }
 }
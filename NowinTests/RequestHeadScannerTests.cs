@@ -0,0 +1,137 @@
+using System.Text;
+using Nowin;
+using Xunit;
+
+namespace NowinTests
+{
+    public class RequestHeadScannerTests
+    {
+        static byte[] Ascii(string text)
+        {
+            return Encoding.ASCII.GetBytes(text);
+        }
+
+        [Fact]
+        public void FindRequestEndFindsTerminatorAtEveryWordAlignment()
+        {
+            // Covers CRLFCRLF starting at each byte of word and straddling two words, from different start offsets
+            for (var start = 0; start < 8; start++)
+            {
+                for (var at = start; at < start + 24; at++)
+                {
+                    var head = new string('a', at) + "\r\n\r\n" + new string('b', 11);
+                    var buffer = Ascii(head);
+                    Assert.Equal(at + 4, RequestHeadScanner.FindRequestEnd(buffer, start, buffer.Length));
+                }
+            }
+        }
+
+        [Fact]
+        public void FindRequestEndFindsFirstTerminator()
+        {
+            var buffer = Ascii("GET / HTTP/1.1\r\n\r\nGET /2 HTTP/1.1\r\n\r\n");
+            Assert.Equal(18, RequestHeadScanner.FindRequestEnd(buffer, 0, buffer.Length));
+            Assert.Equal(buffer.Length, RequestHeadScanner.FindRequestEnd(buffer, 18, buffer.Length));
+        }
+
+        [Fact]
+        public void FindRequestEndWaitsForHeadSplitAcrossReceives()
+        {
+            var buffer = Ascii("GET /some/path HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            for (var received = 0; received < buffer.Length; received++)
+            {
+                Assert.Equal(-1, RequestHeadScanner.FindRequestEnd(buffer, 0, received));
+            }
+            Assert.Equal(buffer.Length, RequestHeadScanner.FindRequestEnd(buffer, 0, buffer.Length));
+        }
+
+        [Fact]
+        public void FindRequestEndFindsHeadEndingExactlyAtBufferEnd()
+        {
+            for (var length = 4; length < 40; length++)
+            {
+                var buffer = Ascii(new string('x', length - 4) + "\r\n\r\n");
+                Assert.Equal(buffer.Length, RequestHeadScanner.FindRequestEnd(buffer, 0, buffer.Length));
+            }
+        }
+
+        [Fact]
+        public void FindRequestEndDoesNotReadPastEnd()
+        {
+            // Terminator just after end must not be found even though it is inside same word
+            var buffer = Ascii("GET / HTTP/1.1\r\nHost: a\r\n\r\n");
+            Assert.Equal(-1, RequestHeadScanner.FindRequestEnd(buffer, 0, buffer.Length - 1));
+            Assert.Equal(-1, RequestHeadScanner.FindRequestEnd(buffer, 0, 3));
+        }
+
+        [Theory]
+        [InlineData("GET / HTTP/1.1\nHost: a\n\n")]
+        [InlineData("GET / HTTP/1.1\r\nHost: a\n\r\n")]
+        [InlineData("GET / HTTP/1.1\r\nHost: a\r\n\n")]
+        [InlineData("GET / HTTP/1.1\r\nHost: a\r\r\n\r")]
+        public void FindRequestEndRequiresCrLfCrLf(string head)
+        {
+            // Bare LF does not end line, such head waits for more data until buffer is full
+            var buffer = Ascii(head);
+            Assert.Equal(-1, RequestHeadScanner.FindRequestEnd(buffer, 0, buffer.Length));
+        }
+
+        [Fact]
+        public void BareLfInsideHeadDoesNotHideTerminator()
+        {
+            var buffer = Ascii("GET / HTTP/1.1\nX: \n\n\r\n\r\n");
+            Assert.Equal(buffer.Length, RequestHeadScanner.FindRequestEnd(buffer, 0, buffer.Length));
+        }
+
+        [Fact]
+        public void SkipToCRStopsAtFirstCrInAnyWordPosition()
+        {
+            for (var at = 0; at < 20; at++)
+            {
+                var buffer = Ascii(new string('a', at) + "\r\n\r\n");
+                for (var start = 0; start <= at; start++)
+                {
+                    var pos = start;
+                    RequestHeadScanner.SkipToCR(buffer, ref pos);
+                    Assert.Equal(at, pos);
+                }
+            }
+        }
+
+        [Fact]
+        public void SkipTokenCharsStopsAtColonSpaceOrControl()
+        {
+            foreach (var stop in new[] { ':', ' ', '\t', '\r' })
+            {
+                for (var at = 0; at < 20; at++)
+                {
+                    var buffer = Ascii(new string('n', at) + stop + "value\r\n\r\n");
+                    var pos = 0;
+                    RequestHeadScanner.SkipTokenChars(buffer, ref pos);
+                    Assert.Equal(at, pos);
+                }
+            }
+        }
+
+        [Fact]
+        public void SearchForFirstSpaceFindsStopCharInAnyWordPosition()
+        {
+            for (var at = 0; at < 20; at++)
+            {
+                foreach (var stop in new[] { ' ', '?', '\r' })
+                {
+                    var buffer = Ascii("/" + new string('p', at) + stop + "x\r\n\r\n");
+                    var pos = 1;
+                    var found = RequestHeadScanner.SearchForFirstSpaceOrQuestionMarkOrEndOfLine(buffer, ref pos);
+                    Assert.Equal((byte)stop, found);
+                    Assert.Equal(at + 1, pos);
+                    // Question mark is part of token when only space or end of line are searched
+                    pos = 1;
+                    found = RequestHeadScanner.SearchForFirstSpaceOrEndOfLine(buffer, ref pos);
+                    Assert.Equal(stop == '?' ? (byte)13 : (byte)stop, found);
+                    Assert.Equal(stop == '?' ? at + 3 : at + 1, pos);
+                }
+            }
+        }
+    }
+}
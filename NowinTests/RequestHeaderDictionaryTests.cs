@@ -0,0 +1,69 @@
+using System.Collections.Generic;
+using System.Linq;
+using Nowin;
+using Xunit;
+
+namespace NowinTests
+{
+    public class RequestHeaderDictionaryTests
+    {
+        [Fact]
+        public void SingleValueIsReturnedAsSameArrayWhileRequestLasts()
+        {
+            var headers = new RequestHeaderDictionary();
+            headers.AddParsed("Accept", "*/*");
+            var values = headers["accept"];
+            Assert.Equal(new[] { "*/*" }, values);
+            Assert.Equal("Accept", headers.Keys.Single());
+            values[0] = "text/plain";
+            Assert.Same(values, headers["Accept"]);
+            Assert.Equal("text/plain", headers["Accept"][0]);
+        }
+
+        [Fact]
+        public void ArrayKeptByApplicationIsNotReusedForNextRequest()
+        {
+            var headers = new RequestHeaderDictionary();
+            headers.AddParsed("Cookie", "a=1");
+            var first = headers["Cookie"];
+            headers.Clear();
+            headers.AddParsed("Cookie", "a=1");
+            Assert.NotSame(first, headers["Cookie"]);
+            Assert.Equal("a=1", first[0]);
+        }
+
+        [Fact]
+        public void RepeatedHeaderCollectsAllValues()
+        {
+            var headers = new RequestHeaderDictionary();
+            headers.AddParsed("X-A", "1");
+            headers.AddParsed("x-a", "2");
+            headers.AddParsed("X-A", "3");
+            headers.AddParsed("X-B", "4");
+            Assert.Equal(2, headers.Count);
+            Assert.Equal(new[] { "1", "2", "3" }, headers["X-A"]);
+            Assert.Equal(new[] { "X-A", "X-B" }, headers.Keys.OrderBy(k => k));
+        }
+
+        [Fact]
+        public void BehavesLikeDictionaryForApplication()
+        {
+            var headers = new RequestHeaderDictionary();
+            headers.AddParsed("Host", "localhost");
+            headers.AddParsed("Accept", "*/*");
+            Assert.True(headers.ContainsKey("HOST"));
+            Assert.Throws<System.ArgumentException>(() => headers.Add("host", new[] { "other" }));
+            headers["Host"] = new[] { "other" };
+            Assert.Equal("other", headers["Host"][0]);
+            Assert.True(headers.Remove("Accept"));
+            Assert.False(headers.ContainsKey("Accept"));
+            string[] values;
+            Assert.False(headers.TryGetValue("Accept", out values));
+            Assert.Throws<KeyNotFoundException>(() => headers["Accept"]);
+            headers.AddParsed("Accept", "text/plain");
+            var all = headers.ToDictionary(p => p.Key, p => p.Value[0]);
+            Assert.Equal(2, all.Count);
+            Assert.Equal("text/plain", all["Accept"]);
+        }
+    }
+}